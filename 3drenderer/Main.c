@@ -1,34 +1,85 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
 #include <SDL2/SDL.h>
 #include "upng.h"
+#include "arena.h"
+#include "binner.h"
+#include "camera.h"
 #include "array.h"
+#include "clipping.h"
 #include "display.h"
+#include "job.h"
 #include "vector.h"
 #include "matrix.h"
 #include "light.h"
 #include "triangle.h"
 #include "texture.h"
 #include "mesh.h"
+#include "node.h"
+#include "scene.h"
+#include "sort.h"
+#include "transform.h"
+#include "stats.h"
 
 #ifndef M_PI
 #define M_PI (3.14159265358979323846)
 #endif
 
 ///////////////////////////////////////////////////////////////////////////////
-// Array of triangles that should be rendered frame by frame
+// Triangles that should be rendered in a frame, with the arena holding them
+// and the rest of the frame's transient data. There are two so the next frame
+// can be built while the current one is drawn.
 ///////////////////////////////////////////////////////////////////////////////
-triangle_t* triangles_to_render = NULL;
+typedef struct {
+    arena_t arena;
+    triangle_t* triangles_to_render;
+    uint32_t* render_order; // back to front drawing order, as indices into triangles_to_render
+} frame_t;
+
+frame_t frames[2];
+int current_frame = 0;
+
+// Arena per job thread for the triangles the geometry jobs assemble
+arena_t* geometry_arenas = NULL;
 
 ///////////////////////////////////////////////////////////////////////////////
 // Global variables for execution status and game loop
 ///////////////////////////////////////////////////////////////////////////////
 bool is_running = false;
-int previous_frame_time = 0;
 
-vec3_t camera_position = { .x = 0, .y = 0, .z = 0 };
+// Fixed rate of the simulation, which advances the animation by whole steps,
+// and the elapsed time not simulated yet, in performance counter ticks
+#define SIMULATION_RATE 90
+#define MAX_STEPS_PER_UPDATE 8
+Uint64 previous_update_time = 0;
+Uint64 simulation_time_left = 0;
+
+// Threads running jobs, the main thread included (0 for one per core), and
+// whether each one is pinned to its own CPU, set from the command line
+int num_job_threads = 0;
+bool pin_job_threads = false;
+
+// Build the next frame while drawing the current one, and whether it is built.
+// Settings changes since then mean it must be built again.
+bool use_pipelining = true;
+bool next_frame_built = false;
+bool settings_changed = false;
+
+mat4_t view_matrix;
 mat4_t proj_matrix;
+plane_t frustum_planes[NUM_FRUSTUM_PLANES];
+
+///////////////////////////////////////////////////////////////////////////////
+// Vertex cache with every vertex of the current mesh instance transformed and
+// projected once, sized for the largest mesh in the scene
+///////////////////////////////////////////////////////////////////////////////
+vec4_t* clip_vertices = NULL;
+vec4_t* projected_vertices = NULL;
+uint8_t* clip_codes = NULL;
+bool use_simd_transform = true;
 
 ///////////////////////////////////////////////////////////////////////////////
 // Setup function to initialize variables and game objects
@@ -37,9 +88,29 @@ void setup(void) {
     // Initialize render mode and triangle culling method
     render_method = RENDER_TEXTURED_WIRE;
     cull_method = CULL_BACKFACE;
+    depth_method = DEPTH_SORT;
+    raster_method = RASTER_EDGE;
+    texel_interpolation = INTERPOLATE_INCREMENTAL;
+
+    // Pace the frames as chosen on the command line, on vsync unless told otherwise
+    set_frame_pacing(frame_pacing);
+
+    // Reserve the frame arenas, which grow to fit the busiest frame seen so far
+    for (int i = 0; i < 2; i++) {
+        arena_init(&frames[i].arena, 64 * 1024);
+    }
 
-    // Allocate the required memory in bytes to hold the color buffer
+    // Start the job threads drawing screen tiles and clearing the buffers
+    job_system_init(num_job_threads > 0 ? num_job_threads : SDL_GetCPUCount(), pin_job_threads);
+    geometry_arenas = (arena_t*)malloc(sizeof(arena_t) * job_threads);
+    for (int i = 0; i < job_threads; i++) {
+        arena_init(&geometry_arenas[i], 64 * 1024);
+    }
+
+    // Allocate the required memory in bytes to hold the color buffer and the z-buffer
     color_buffer = (uint32_t*)malloc(sizeof(uint32_t) * window_width * window_height);
+    z_buffer = (float*)malloc(sizeof(float) * window_width * window_height);
+    depth_tiles = (depth_tile_t*)malloc(sizeof(depth_tile_t) * depth_tile_count());
 
     // Creating a SDL texture that is used to display the color buffer
     color_buffer_texture = SDL_CreateTexture(
@@ -56,13 +127,38 @@ void setup(void) {
     float znear = 0.1;
     float zfar = 100.0;
     proj_matrix = mat4_make_perspective(fov, aspect, znear, zfar);
+    init_frustum_planes(proj_matrix, frustum_planes);
+
+    // Loads the vertex and face values and the texture of the meshes in the scene
+    init_scene();
+    mesh_t* cube_mesh = load_cube_mesh("./assets/cube.png");
+    // mesh_t* f22_mesh = load_obj_mesh("./assets/f22.obj", NULL);
+
+    // Place instances of the meshes in the world, each with its own transform
+    node_t* cube_instance = add_mesh_instance(cube_mesh, NULL);
+    node_set_translation(cube_instance, (vec3_t){ 0, 0, 5.0 });
+    // for (int i = 0; i < 100; i++) {
+    //     node_t* f22_instance = add_mesh_instance(f22_mesh, NULL);
+    //     node_set_translation(f22_instance, (vec3_t){ (i % 10 - 4.5) * 3.0, (i / 10 - 4.5) * 3.0, 30.0 });
+    // }
+
+    // Start the simulation from the placed transforms, with nothing moving yet
+    node_save_previous_transforms(scene.root);
+    previous_update_time = SDL_GetPerformanceCounter();
+
+    // Allocate the vertex cache to hold one entry per vertex of the largest mesh
+    int num_vertices = scene.max_vertices_per_mesh;
+    clip_vertices = (vec4_t*)malloc(sizeof(vec4_t) * num_vertices);
+    projected_vertices = (vec4_t*)malloc(sizeof(vec4_t) * num_vertices);
+    clip_codes = (uint8_t*)malloc(sizeof(uint8_t) * num_vertices);
+}
 
-    // Loads the vertex and face values for the mesh data structure
-    load_cube_mesh_data();
-    // load_obj_file_data("./assets/f22.obj");
-
-    // Load the texture from png file
-    load_png_texture_data("./assets/cube.png");
+///////////////////////////////////////////////////////////////////////////////
+// Check if a key moves the camera rather than changing a setting
+///////////////////////////////////////////////////////////////////////////////
+bool is_camera_key(SDL_Keycode key) {
+    return key == SDLK_UP || key == SDLK_DOWN || key == SDLK_LEFT || key == SDLK_RIGHT ||
+           key == SDLK_w || key == SDLK_s || key == SDLK_a || key == SDLK_f;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -76,6 +172,8 @@ void process_input(void) {
             is_running = false;
             break;
         case SDL_KEYDOWN:
+            if (!is_camera_key(event.key.keysym.sym))
+                settings_changed = true;
             if (event.key.keysym.sym == SDLK_ESCAPE)
                 is_running = false;
             if (event.key.keysym.sym == SDLK_1)
@@ -90,227 +188,561 @@ void process_input(void) {
                 render_method = RENDER_TEXTURED;
             if (event.key.keysym.sym == SDLK_6)
                 render_method = RENDER_TEXTURED_WIRE;
+            if (event.key.keysym.sym == SDLK_7)
+                render_method = RENDER_TEXTURED_AFFINE;
             if (event.key.keysym.sym == SDLK_c)
                 cull_method = CULL_BACKFACE;
             if (event.key.keysym.sym == SDLK_d)
                 cull_method = CULL_NONE;
+            if (event.key.keysym.sym == SDLK_z)
+                depth_method = (depth_method == DEPTH_SORT) ? DEPTH_BUFFER : DEPTH_SORT;
+            if (event.key.keysym.sym == SDLK_r)
+                raster_method = (raster_method == RASTER_SCANLINE) ? RASTER_EDGE : RASTER_SCANLINE;
+            if (event.key.keysym.sym == SDLK_h)
+                use_depth_tiles = !use_depth_tiles;
+            if (event.key.keysym.sym == SDLK_b)
+                use_tile_binning = !use_tile_binning;
+            if (event.key.keysym.sym == SDLK_l)
+                use_pipelining = !use_pipelining;
+            if (event.key.keysym.sym == SDLK_y)
+                set_frame_pacing(frame_pacing == PACING_VSYNC ? PACING_UNCAPPED : frame_pacing == PACING_UNCAPPED ? PACING_TARGET_RATE : PACING_VSYNC);
+            if (event.key.keysym.sym == SDLK_i)
+                texel_interpolation = (texel_interpolation == INTERPOLATE_BARYCENTRIC) ? INTERPOLATE_INCREMENTAL : INTERPOLATE_BARYCENTRIC;
+            if (event.key.keysym.sym == SDLK_p)
+                stats_enabled = !stats_enabled;
+            if (event.key.keysym.sym == SDLK_v)
+                use_simd_transform = !use_simd_transform;
+            if (event.key.keysym.sym == SDLK_UP)
+                camera_move_forward(0.1);
+            if (event.key.keysym.sym == SDLK_DOWN)
+                camera_move_forward(-0.1);
+            if (event.key.keysym.sym == SDLK_LEFT)
+                camera_rotate(-0.03, 0);
+            if (event.key.keysym.sym == SDLK_RIGHT)
+                camera_rotate(0.03, 0);
+            if (event.key.keysym.sym == SDLK_w)
+                camera_rotate(0, 0.03);
+            if (event.key.keysym.sym == SDLK_s)
+                camera_rotate(0, -0.03);
+            if (event.key.keysym.sym == SDLK_a)
+                camera_move_right(-0.1);
+            if (event.key.keysym.sym == SDLK_f)
+                camera_move_right(0.1);
             break;
     }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-// Update function frame by frame with a fixed time step
+// Check if the render mode draws triangle outlines
 ///////////////////////////////////////////////////////////////////////////////
-void update(void) {
-    // Wait some time until the reach the target frame time in milliseconds
-    int time_to_wait = FRAME_TARGET_TIME - (SDL_GetTicks() - previous_frame_time);
+bool wireframe_enabled(void) {
+    return render_method == RENDER_WIRE || render_method == RENDER_WIRE_VERTEX || render_method == RENDER_FILL_TRIANGLE_WIRE || render_method == RENDER_TEXTURED_WIRE;
+}
 
-    // Only delay execution if we are running too fast
-    if (time_to_wait > 0 && time_to_wait <= FRAME_TARGET_TIME) {
-        SDL_Delay(time_to_wait);
+///////////////////////////////////////////////////////////////////////////////
+// Hand the mesh edges of a face to the triangle at index triangle_index of
+// triangles, with the triangles before it already claimed, and return its
+// wire_edges. An edge already owned by another triangle goes to whichever of
+// the two is drawn last, since that draw of the line is the one that ends up
+// on screen. The z-buffer draws in submission order; the painter's sort is
+// stable, so ties in depth keep it too.
+///////////////////////////////////////////////////////////////////////////////
+uint8_t claim_face_edges(triangle_t* triangles, mesh_t* mesh, int face_index, int* edge_owners, int triangle_index, float avg_depth) {
+    uint8_t wire_edges = 0;
+    for (int j = 0; j < 3; j++) {
+        int edge = mesh->face_edges[face_index * 3 + j];
+        int owner = edge_owners[edge];
+        if (owner >= 0) {
+            triangle_t* owner_triangle = &triangles[owner / 3];
+            frame_stats.wire_edges_shared++;
+            if (depth_method == DEPTH_SORT && avg_depth > owner_triangle->avg_depth) {
+                continue;
+            }
+            owner_triangle->wire_edges &= ~(1 << (owner % 3));
+        }
+        edge_owners[edge] = triangle_index * 3 + j;
+        wire_edges |= 1 << j;
     }
+    return wire_edges;
+}
 
-    previous_frame_time = SDL_GetTicks();
-
-    // Initialize the array of triangles to render
-    triangles_to_render = NULL;
-
-    // Change the mesh scale, rotation, and translation values per animation frame
-    mesh.rotation.x += 0.000;
-    mesh.rotation.y += 0.01;
-
-    mesh.rotation.z += 0.000;
-    mesh.translation.z = 5.0;
+///////////////////////////////////////////////////////////////////////////////
+// Geometry stage of one mesh instance, split into jobs over fixed chunks of
+// vertices and faces. Each face chunk appends its triangles to an array in
+// the arena of the thread running it, and the chunks are then copied into the
+// frame's triangles_to_render in chunk order, so the triangles come out in
+// face order whichever threads ran the chunks.
+///////////////////////////////////////////////////////////////////////////////
+#define GEOMETRY_CHUNK_VERTICES 4096 // a multiple of 8 for the aligned SIMD loads
+#define GEOMETRY_CHUNK_FACES 1024
+
+typedef struct {
+    triangle_t* triangles; // array in the arena of the thread that ran the chunk
+    int offset;            // index of the chunk's first triangle in triangles_to_render
+} geometry_chunk_t;
+
+typedef struct {
+    frame_t* frame;
+    mesh_t* mesh;
+    mat4_t mvp_matrix;
+    mat4_t normal_matrix;
+    vec3_t object_camera_position;
+    geometry_chunk_t* chunks;
+} geometry_pass_t;
 
-    // Create scale, rotation, and translation matrices that will be used to multiply the mesh vertices
-    mat4_t scale_matrix = mat4_make_scale(mesh.scale.x, mesh.scale.y, mesh.scale.z);
-    mat4_t translation_matrix = mat4_make_translation(mesh.translation.x, mesh.translation.y, mesh.translation.z);
-    mat4_t rotation_matrix_x = mat4_make_rotation_x(mesh.rotation.x);
-    mat4_t rotation_matrix_y = mat4_make_rotation_y(mesh.rotation.y);
-    mat4_t rotation_matrix_z = mat4_make_rotation_z(mesh.rotation.z);
+///////////////////////////////////////////////////////////////////////////////
+// Job transforming, projecting, and classifying against the six frustum
+// planes the vertices of the chunks from start to end
+///////////////////////////////////////////////////////////////////////////////
+void process_vertices(void* data, int start, int end) {
+    geometry_pass_t* pass = (geometry_pass_t*)data;
+    vertex_streams_t* streams = &pass->mesh->vertex_streams;
+    int first = start * GEOMETRY_CHUNK_VERTICES;
+    int last = (end * GEOMETRY_CHUNK_VERTICES < streams->count) ? end * GEOMETRY_CHUNK_VERTICES : streams->count;
+    if (use_simd_transform) {
+        transform_vertices(streams, first, last, pass->mvp_matrix, clip_vertices, projected_vertices);
+    } else {
+        transform_vertices_scalar(streams, first, last, pass->mvp_matrix, clip_vertices, projected_vertices);
+    }
+    for (int i = first; i < last; i++) {
+        clip_codes[i] = clip_outcode(clip_vertices[i]);
+    }
+}
 
-    // Loop all triangle faces of our mesh
-    int num_faces = array_length(mesh.faces);
-    for (int i = 0; i < num_faces; i++) {
-        face_t mesh_face = mesh.faces[i];
+///////////////////////////////////////////////////////////////////////////////
+// Job culling, lighting, and clipping the faces of the chunks from start to
+// end, reading the transformed vertices by index from the vertex cache
+///////////////////////////////////////////////////////////////////////////////
+void process_faces(void* data, int start, int end) {
+    geometry_pass_t* pass = (geometry_pass_t*)data;
+    mesh_t* mesh = pass->mesh;
+    arena_t* arena = &geometry_arenas[job_thread_index()];
+    int num_faces = array_length(mesh->faces);
+
+    for (int chunk = start; chunk < end; chunk++) {
+        triangle_t* triangles = NULL;
+        int first_face = chunk * GEOMETRY_CHUNK_FACES;
+        int last_face = (first_face + GEOMETRY_CHUNK_FACES < num_faces) ? first_face + GEOMETRY_CHUNK_FACES : num_faces;
+        for (int i = first_face; i < last_face; i++) {
+            face_t mesh_face = mesh->faces[i];
+
+            // Face assembly reads the transformed vertices by index from the vertex cache
+            int face_indices[3] = { mesh_face.a - 1, mesh_face.b - 1, mesh_face.c - 1 };
+
+            // Skip faces with all three vertices outside the same frustum plane
+            uint8_t codes_outside_all = clip_codes[face_indices[0]] & clip_codes[face_indices[1]] & clip_codes[face_indices[2]];
+            uint8_t codes_outside_any = clip_codes[face_indices[0]] | clip_codes[face_indices[1]] | clip_codes[face_indices[2]];
+            if (codes_outside_all != 0) {
+                frame_stats.faces_outside_frustum++;
+                continue;
+            }
 
-        vec3_t face_vertices[3];
-        face_vertices[0] = mesh.vertices[mesh_face.a - 1];
-        face_vertices[1] = mesh.vertices[mesh_face.b - 1];
-        face_vertices[2] = mesh.vertices[mesh_face.c - 1];
+            // Backface culling test in object space, against the camera moved into object space
+            if (cull_method == CULL_BACKFACE) {
+                // Find the vector between vertex A in the triangle and the camera origin
+                vec3_t camera_ray = vec3_sub(pass->object_camera_position, mesh->vertices[face_indices[0]]);
 
-        vec4_t transformed_vertices[3];
+                // Bypass triangles that are looking away from the camera
+                if (vec3_dot(mesh->face_normals[i], camera_ray) < 0) {
+                    continue;
+                }
+            }
 
-        // Loop all three vertices of this current face and apply transformations
-        for (int j = 0; j < 3; j++) {
-            vec4_t transformed_vertex = vec4_from_vec3(face_vertices[j]);
+            // Calculate the average depth for each face from clip space w, which holds the view space z
+            float avg_depth = (
+                clip_vertices[face_indices[0]].w + clip_vertices[face_indices[1]].w + clip_vertices[face_indices[2]].w
+            ) / 3.0;
+
+            // Bring the precomputed face normal into world space with the normal matrix for lighting
+            vec3_t normal = mat4_mul_direction(pass->normal_matrix, mesh->face_normals[i]);
+            vec3_normalize(&normal);
+
+            // Calculate the shade intensity based on how aliged is the normal with the flipped light direction ray
+            float light_intensity_factor = -vec3_dot(normal, light.direction);
+
+            // Calculate the triangle color based on the light angle
+            uint32_t triangle_color = light_apply_intensity(mesh_face.color, light_intensity_factor);
+
+            // Faces fully inside the frustum use the projected vertices from the vertex cache
+            if (codes_outside_any == 0) {
+                vec4_t projected_points[3];
+                for (int j = 0; j < 3; j++) {
+                    projected_points[j] = projected_vertices[face_indices[j]];
+                }
+
+                triangle_t projected_triangle = {
+                    .points = {
+                        { projected_points[0].x, projected_points[0].y, projected_points[0].z, projected_points[0].w },
+                        { projected_points[1].x, projected_points[1].y, projected_points[1].z, projected_points[1].w },
+                        { projected_points[2].x, projected_points[2].y, projected_points[2].z, projected_points[2].w },
+                    },
+                    .texcoords = {
+                        { mesh_face.a_uv.u, mesh_face.a_uv.v },
+                        { mesh_face.b_uv.u, mesh_face.b_uv.v },
+                        { mesh_face.c_uv.u, mesh_face.c_uv.v }
+                    },
+                    .color = triangle_color,
+                    .avg_depth = avg_depth,
+                    .texture = &mesh->texture,
+                    .wire_edges = TRIANGLE_ALL_EDGES,
+                    .face_index = i
+                };
+
+                // Save the projected triangle in the chunk's array of triangles
+                array_push_arena(arena, triangles, projected_triangle);
+                continue;
+            }
 
-            // Create a World Matrix combining scale, rotation, and translation matrices
-            mat4_t world_matrix = mat4_identity();
+            // Faces crossing the frustum are clipped in clip space against the planes they cross
+            polygon_t polygon = create_polygon_from_triangle(
+                clip_vertices[face_indices[0]], clip_vertices[face_indices[1]], clip_vertices[face_indices[2]],
+                mesh_face.a_uv, mesh_face.b_uv, mesh_face.c_uv
+            );
+            clip_polygon(&polygon, codes_outside_any);
+            frame_stats.faces_clipped++;
+
+            // Break the clipped polygon back into triangles with the color and depth of the face
+            triangle_t triangles_after_clipping[MAX_NUM_POLY_TRIANGLES];
+            int num_triangles_after_clipping = triangles_from_polygon(&polygon, triangles_after_clipping);
+            for (int t = 0; t < num_triangles_after_clipping; t++) {
+                triangle_t projected_triangle = triangles_after_clipping[t];
+                projected_triangle.color = triangle_color;
+                projected_triangle.avg_depth = avg_depth;
+                projected_triangle.texture = &mesh->texture;
+                projected_triangle.wire_edges = TRIANGLE_ALL_EDGES;
+                projected_triangle.face_index = -1;
+                array_push_arena(arena, triangles, projected_triangle);
+            }
+        }
+        pass->chunks[chunk].triangles = triangles;
+    }
+}
 
-            // Order matters: First scale, then rotate, then translate. [T]*[R]*[S]*v
-            world_matrix = mat4_mul_mat4(scale_matrix, world_matrix);
-            world_matrix = mat4_mul_mat4(rotation_matrix_z, world_matrix);
-            world_matrix = mat4_mul_mat4(rotation_matrix_y, world_matrix);
-            world_matrix = mat4_mul_mat4(rotation_matrix_x, world_matrix);
-            world_matrix = mat4_mul_mat4(translation_matrix, world_matrix);
+///////////////////////////////////////////////////////////////////////////////
+// Job copying the triangles of the chunks from start to end to their place in
+// the frame's triangles_to_render
+///////////////////////////////////////////////////////////////////////////////
+void copy_chunk_triangles(void* data, int start, int end) {
+    geometry_pass_t* pass = (geometry_pass_t*)data;
+    triangle_t* triangles_to_render = pass->frame->triangles_to_render;
+    for (int chunk = start; chunk < end; chunk++) {
+        geometry_chunk_t* output = &pass->chunks[chunk];
+        int count = array_length(output->triangles);
+        if (count > 0) {
+            memcpy(&triangles_to_render[output->offset], output->triangles, sizeof(triangle_t) * count);
+        }
+    }
+}
 
-            // Multiply the world matrix by the original vector
-            transformed_vertex = mat4_mul_vec4(world_matrix, transformed_vertex);
+///////////////////////////////////////////////////////////////////////////////
+// Run the vertex stage and face assembly for a mesh placed with a world matrix,
+// appending its visible triangles to the frame's triangles_to_render
+///////////////////////////////////////////////////////////////////////////////
+void process_mesh(frame_t* frame, mesh_t* mesh, mat4_t world_matrix) {
+    geometry_pass_t pass;
+    pass.frame = frame;
+    pass.mesh = mesh;
+
+    // Concatenate projection * view * world once, so each vertex pays a single multiply into clip space
+    mat4_t model_view_matrix = mat4_mul_mat4(view_matrix, world_matrix);
+    pass.mvp_matrix = mat4_mul_mat4(proj_matrix, model_view_matrix);
+
+    // Cull the whole mesh when its bounding sphere or box is outside the view frustum
+    vec4_t view_center = mat4_mul_vec4(model_view_matrix, vec4_from_vec3(mesh->bounding_center));
+    float view_radius = mesh->bounding_radius * mat4_max_scale(model_view_matrix);
+    if (sphere_outside_frustum(frustum_planes, vec3_from_vec4(view_center), view_radius) ||
+        aabb_outside_frustum(pass.mvp_matrix, mesh->aabb_min, mesh->aabb_max)) {
+        frame_stats.objects_culled++;
+        return;
+    }
 
-            // Save transformed vertex in the array of transformed vertices
-            transformed_vertices[j] = transformed_vertex;
+    // Transform, project, and classify every vertex of the mesh exactly once
+    Uint64 vertex_stage_start = SDL_GetPerformanceCounter();
+    int num_vertices = mesh->vertex_streams.count;
+    int num_vertex_chunks = (num_vertices + GEOMETRY_CHUNK_VERTICES - 1) / GEOMETRY_CHUNK_VERTICES;
+    job_parallel_for(num_vertex_chunks, 1, process_vertices, &pass);
+    frame_stats.vertex_transforms += num_vertices;
+    frame_stats.vertex_stage_time += SDL_GetPerformanceCounter() - vertex_stage_start;
+
+    // The dot product of a face normal and a camera ray keeps its sign under the world transform,
+    // so backface culling uses object space normals and the camera in object space
+    mat4_t world_inverse = mat4_inverse(world_matrix);
+    pass.object_camera_position = vec3_from_vec4(mat4_mul_vec4(world_inverse, vec4_from_vec3(camera.position)));
+
+    // Normals transform by the inverse-transpose of the world matrix to stay perpendicular to the face
+    pass.normal_matrix = mat4_transpose(world_inverse);
+
+    // Assemble the triangles of every chunk of faces
+    int num_faces = array_length(mesh->faces);
+    int num_face_chunks = (num_faces + GEOMETRY_CHUNK_FACES - 1) / GEOMETRY_CHUNK_FACES;
+    frame_stats.face_vertices += num_faces * 3;
+    pass.chunks = (geometry_chunk_t*)arena_alloc(&frame->arena, sizeof(geometry_chunk_t) * num_face_chunks);
+    job_parallel_for(num_face_chunks, 1, process_faces, &pass);
+
+    // Give each chunk its place after the triangles of the chunks before it, and copy them there
+    int first_triangle = array_length(frame->triangles_to_render);
+    int num_triangles = 0;
+    for (int i = 0; i < num_face_chunks; i++) {
+        pass.chunks[i].offset = first_triangle + num_triangles;
+        num_triangles += array_length(pass.chunks[i].triangles);
+    }
+    if (num_triangles == 0) {
+        return;
+    }
+    frame->triangles_to_render = array_hold_arena(&frame->arena, frame->triangles_to_render, num_triangles, sizeof(triangle_t));
+    job_parallel_for(num_face_chunks, 1, copy_chunk_triangles, &pass);
+
+    // In the wireframe modes, each visible mesh edge is drawn once, by the last drawn triangle of its faces.
+    // The claims depend on the triangle order, so they run in order once the chunks are in place.
+    if (wireframe_enabled()) {
+        int num_edges = array_length(mesh->edges);
+        int* edge_owners = (int*)arena_alloc(&frame->arena, sizeof(int) * num_edges);
+        for (int i = 0; i < num_edges; i++) {
+            edge_owners[i] = -1;
         }
+        for (int i = first_triangle; i < first_triangle + num_triangles; i++) {
+            triangle_t* triangle = &frame->triangles_to_render[i];
+            if (triangle->face_index >= 0) {
+                triangle->wire_edges = claim_face_edges(frame->triangles_to_render, mesh, triangle->face_index, edge_owners, i, triangle->avg_depth);
+            }
+        }
+    }
+}
 
-        // Get individual vectors from A, B, and C vertices to compute normal
-        vec3_t vector_a = vec3_from_vec4(transformed_vertices[0]); /*   A   */
-        vec3_t vector_b = vec3_from_vec4(transformed_vertices[1]); /*  / \  */
-        vec3_t vector_c = vec3_from_vec4(transformed_vertices[2]); /* C---B */
-
-        // Get the vector subtraction of B-A and C-A
-        vec3_t vector_ab = vec3_sub(vector_b, vector_a);
-        vec3_t vector_ac = vec3_sub(vector_c, vector_a);
-        vec3_normalize(&vector_ab);
-        vec3_normalize(&vector_ac);
+///////////////////////////////////////////////////////////////////////////////
+// Advance the simulation by one fixed step of 1 / SIMULATION_RATE seconds
+///////////////////////////////////////////////////////////////////////////////
+void simulate_step(void) {
+    node_save_previous_transforms(scene.root);
+
+    // Change the rotation of every mesh instance per simulation step
+    int num_instances = array_length(scene.instances);
+    for (int i = 0; i < num_instances; i++) {
+        node_t* instance = scene.instances[i];
+        vec3_t rotation = instance->rotation;
+        rotation.y += 0.01;
+        node_set_rotation(instance, rotation);
+    }
+}
 
-        // Compute the face normal (using cross product to find perpendicular)
-        vec3_t normal = vec3_cross(vector_ab, vector_ac);
-        vec3_normalize(&normal);
+///////////////////////////////////////////////////////////////////////////////
+// Update function frame by frame, running the fixed simulation steps the real
+// time elapsed since the last update calls for, and placing the scene between
+// the last two steps by the time left over, so motion is smooth at any frame
+// rate. Also takes the camera the next frame is built from.
+///////////////////////////////////////////////////////////////////////////////
+void update(void) {
+    Uint64 now = SDL_GetPerformanceCounter();
+    Uint64 step_time = SDL_GetPerformanceFrequency() / SIMULATION_RATE;
+    Uint64 elapsed = now - previous_update_time;
+    previous_update_time = now;
+
+    // After a stall, let the simulation fall behind rather than spend frames catching up
+    if (elapsed > step_time * MAX_STEPS_PER_UPDATE) {
+        elapsed = step_time * MAX_STEPS_PER_UPDATE;
+    }
+    simulation_time_left += elapsed;
+    while (simulation_time_left >= step_time) {
+        simulate_step();
+        simulation_time_left -= step_time;
+    }
 
-        // Find the vector between vertex A in the triangle and the camera origin
-        vec3_t camera_ray = vec3_sub(camera_position, vector_a);
+    // Create the view matrix looking from the camera position along the camera direction
+    view_matrix = camera_view_matrix();
 
-        // Calculate how aligned the camera ray is with the face normal (using dot product)
-        float dot_normal_camera = vec3_dot(normal, camera_ray);
+    // Recompute the world matrices of the nodes that changed or move between the last two steps
+    float alpha = (float)simulation_time_left / step_time;
+    node_update_world_matrices(scene.root, alpha);
+}
 
-        // Backface culling test to see if the current face should be projected
-        if (cull_method == CULL_BACKFACE) {
-            // Backface culling, bypassing triangles that are looking away from the camera
-            if (dot_normal_camera < 0) {
-                continue;
-            }
+///////////////////////////////////////////////////////////////////////////////
+// Build the triangles of a frame from the scene as last updated, in drawing
+// order. Reads the scene, the camera, and the settings, which must not change
+// until it returns.
+///////////////////////////////////////////////////////////////////////////////
+void build_frame(frame_t* frame) {
+    // Release the frame's previous transient data and start a new array of triangles to render
+    arena_reset(&frame->arena);
+    for (int i = 0; i < job_threads; i++) {
+        arena_reset(&geometry_arenas[i]);
+    }
+    frame->triangles_to_render = NULL;
+
+    // With the z-buffer, submit the instances nearest first so hidden pixels are rejected before shading
+    int num_instances = array_length(scene.instances);
+    uint32_t* instance_order = NULL;
+    if (depth_method == DEPTH_BUFFER) {
+        float* instance_depths = (float*)arena_alloc(&frame->arena, sizeof(float) * num_instances);
+        for (int i = 0; i < num_instances; i++) {
+            node_t* instance = scene.instances[i];
+            vec4_t center = vec4_from_vec3(instance->mesh->bounding_center);
+            instance_depths[i] = mat4_mul_vec4(mat4_mul_mat4(view_matrix, instance->world_matrix), center).z;
         }
+        instance_order = sort_front_to_back(&frame->arena, instance_depths, num_instances);
+    }
 
-        vec4_t projected_points[3];
-
-        // Loop all three vertices to perform projection
-        for (int j = 0; j < 3; j++) {
-            // Project the current vertex
-            projected_points[j] = mat4_mul_vec4_project(proj_matrix, transformed_vertices[j]);
-
-            // Flip vertically since the y values of the 3D mesh grow bottom->up and in screen space y values grow top->down
-            projected_points[j].y *= -1;
+    // Instances reuse the vertices, faces, and bounds of their mesh with their own world matrix
+    for (int i = 0; i < num_instances; i++) {
+        node_t* instance = scene.instances[instance_order != NULL ? instance_order[i] : i];
+        process_mesh(frame, instance->mesh, instance->world_matrix);
+    }
 
-            // Scale into the view
-            projected_points[j].x *= (window_width / 2.0);
-            projected_points[j].y *= (window_height / 2.0);
+    // Sort the triangles to render by their avg_depth, unless the z-buffer resolves visibility
+    int num_triangles = array_length(frame->triangles_to_render);
+    frame->render_order = NULL;
+    if (depth_method == DEPTH_SORT) {
+        frame->render_order = sort_triangles_by_depth(&frame->arena, frame->triangles_to_render, num_triangles);
+    }
 
-            // Translate the projected points to the middle of the screen
-            projected_points[j].x += (window_width / 2.0);
-            projected_points[j].y += (window_height / 2.0);
+    // Count the lines the wireframe will draw, once each whatever tiles they cross
+    if (wireframe_enabled()) {
+        for (int i = 0; i < num_triangles; i++) {
+            uint8_t edges = frame->triangles_to_render[i].wire_edges;
+            frame_stats.wire_lines += (edges & 1) + ((edges >> 1) & 1) + (edges >> 2);
         }
+    }
 
-        // Calculate the average depth for each face based on the vertices after transformation
-        float avg_depth = (transformed_vertices[0].z + transformed_vertices[1].z + transformed_vertices[2].z) / 3.0;
+    frame_stats.arena_used = frame->arena.used;
+    frame_stats.arena_high_water_mark = frame->arena.high_water_mark;
+    frame_stats.arena_heap_allocations = frame->arena.heap_allocations;
+    for (int i = 0; i < job_threads; i++) {
+        frame_stats.arena_used += geometry_arenas[i].used;
+        frame_stats.arena_high_water_mark += geometry_arenas[i].high_water_mark;
+        frame_stats.arena_heap_allocations += geometry_arenas[i].heap_allocations;
+    }
+}
 
-        // Calculate the shade intensity based on how aliged is the normal with the flipped light direction ray
-        float light_intensity_factor = -vec3_dot(normal, light.direction);
+void build_frame_job(void* data, int start, int end) {
+    (void)start;
+    (void)end;
+    build_frame((frame_t*)data);
+}
 
-        // Calculate the triangle color based on the light angle
-        uint32_t triangle_color = light_apply_intensity(mesh_face.color, light_intensity_factor);
+// Pixels the vertex markers of RENDER_WIRE_VERTEX reach past the vertices
+#define VERTEX_MARKER_MARGIN 4
 
-        triangle_t projected_triangle = {
-            .points = {
-                { projected_points[0].x, projected_points[0].y, projected_points[0].z, projected_points[0].w },
-                { projected_points[1].x, projected_points[1].y, projected_points[1].z, projected_points[1].w },
-                { projected_points[2].x, projected_points[2].y, projected_points[2].z, projected_points[2].w },
-            },
-            .texcoords = {
-                { mesh_face.a_uv.u, mesh_face.a_uv.v },
-                { mesh_face.b_uv.u, mesh_face.b_uv.v },
-                { mesh_face.c_uv.u, mesh_face.c_uv.v }
-            },
-            .color = triangle_color,
-            .avg_depth = avg_depth
-        };
+///////////////////////////////////////////////////////////////////////////////
+// Draw one triangle in the current render mode, writing only inside the clip
+// rectangle
+///////////////////////////////////////////////////////////////////////////////
+void draw_render_triangle(triangle_t* triangle, rect_t clip) {
+    // Meshes without a texture fall back to a filled triangle in the textured modes
+    bool has_texture = triangle->texture != NULL && triangle->texture->pixels != NULL;
+    bool textured = render_method == RENDER_TEXTURED || render_method == RENDER_TEXTURED_WIRE || render_method == RENDER_TEXTURED_AFFINE;
+
+    Uint64 raster_start = SDL_GetPerformanceCounter();
+
+    // Draw filled triangle
+    if (render_method == RENDER_FILL_TRIANGLE || render_method == RENDER_FILL_TRIANGLE_WIRE || (textured && !has_texture)) {
+        draw_filled_triangle(
+            triangle->points[0].x, triangle->points[0].y, triangle->points[0].w, // vertex A
+            triangle->points[1].x, triangle->points[1].y, triangle->points[1].w, // vertex B
+            triangle->points[2].x, triangle->points[2].y, triangle->points[2].w, // vertex C
+            triangle->color, clip
+        );
+    }
 
-        // Save the projected triangle in the array of triangles to render
-        array_push(triangles_to_render, projected_triangle);
+    // Draw textured triangle
+    if (textured && has_texture) {
+        draw_textured_triangle(
+            triangle->points[0].x, triangle->points[0].y, triangle->points[0].z, triangle->points[0].w, triangle->texcoords[0].u, triangle->texcoords[0].v, // vertex A
+            triangle->points[1].x, triangle->points[1].y, triangle->points[1].z, triangle->points[1].w, triangle->texcoords[1].u, triangle->texcoords[1].v, // vertex B
+            triangle->points[2].x, triangle->points[2].y, triangle->points[2].z, triangle->points[2].w, triangle->texcoords[2].u, triangle->texcoords[2].v, // vertex C
+            triangle->texture, clip
+        );
+    }
+    frame_stats.raster_time += SDL_GetPerformanceCounter() - raster_start;
+
+    // Draw triangle wireframe
+    if (wireframe_enabled()) {
+        draw_triangle(
+            triangle->points[0].x, triangle->points[0].y, // vertex A
+            triangle->points[1].x, triangle->points[1].y, // vertex B
+            triangle->points[2].x, triangle->points[2].y, // vertex C
+            triangle->wire_edges,
+            0xFFFFFFFF, clip
+        );
     }
 
-    // Sort the triangles to render by their avg_depth
-    int num_triangles = array_length(triangles_to_render);
-    for (int i = 0; i < num_triangles; i++) {
-        for (int j = i; j < num_triangles; j++) {
-            if (triangles_to_render[i].avg_depth < triangles_to_render[j].avg_depth) {
-                // Swap the triangles positions in the array
-                triangle_t temp = triangles_to_render[i];
-                triangles_to_render[i] = triangles_to_render[j];
-                triangles_to_render[j] = temp;
-            }
-        }
+    // Draw triangle vertex points
+    if (render_method == RENDER_WIRE_VERTEX) {
+        draw_rect(triangle->points[0].x - 3, triangle->points[0].y - 3, 6, 6, 0xFFFF0000, clip); // vertex A
+        draw_rect(triangle->points[1].x - 3, triangle->points[1].y - 3, 6, 6, 0xFFFF0000, clip); // vertex B
+        draw_rect(triangle->points[2].x - 3, triangle->points[2].y - 3, 6, 6, 0xFFFF0000, clip); // vertex C
     }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-// Render function to draw objects on the display
+// Render function to draw the triangles of a frame on the display
 ///////////////////////////////////////////////////////////////////////////////
-void render(void) {
+void render(frame_t* frame) {
     SDL_RenderClear(renderer);
 
     draw_grid();
 
-    // Loop all projected triangles and render them
-    int num_triangles = array_length(triangles_to_render);
-    for (int i = 0; i < num_triangles; i++) {
-        triangle_t triangle = triangles_to_render[i];
-
-        // Draw filled triangle
-        if (render_method == RENDER_FILL_TRIANGLE || render_method == RENDER_FILL_TRIANGLE_WIRE) {
-            draw_filled_triangle(
-                triangle.points[0].x, triangle.points[0].y, // vertex A
-                triangle.points[1].x, triangle.points[1].y, // vertex B
-                triangle.points[2].x, triangle.points[2].y, // vertex C
-                triangle.color
-            );
-        }
-
-        // Draw textured triangle
-        if (render_method == RENDER_TEXTURED || render_method == RENDER_TEXTURED_WIRE) {
-            draw_textured_triangle(
-                triangle.points[0].x, triangle.points[0].y, triangle.points[0].z, triangle.points[0].w, triangle.texcoords[0].u, triangle.texcoords[0].v, // vertex A
-                triangle.points[1].x, triangle.points[1].y, triangle.points[1].z, triangle.points[1].w, triangle.texcoords[1].u, triangle.texcoords[1].v, // vertex B
-                triangle.points[2].x, triangle.points[2].y, triangle.points[2].z, triangle.points[2].w, triangle.texcoords[2].u, triangle.texcoords[2].v, // vertex C
-                mesh_texture
-            );
-        }
-
-        // Draw triangle wireframe
-        if (render_method == RENDER_WIRE || render_method == RENDER_WIRE_VERTEX || render_method == RENDER_FILL_TRIANGLE_WIRE || render_method == RENDER_TEXTURED_WIRE) {
-            draw_triangle(
-                triangle.points[0].x, triangle.points[0].y, // vertex A
-                triangle.points[1].x, triangle.points[1].y, // vertex B
-                triangle.points[2].x, triangle.points[2].y, // vertex C
-                0xFFFFFFFF
-            );
-        }
+    if (depth_method == DEPTH_BUFFER) {
+        clear_z_buffer();
+    }
 
-        // Draw triangle vertex points
-        if (render_method == RENDER_WIRE_VERTEX) {
-            draw_rect(triangle.points[0].x - 3, triangle.points[0].y - 3, 6, 6, 0xFFFF0000); // vertex A
-            draw_rect(triangle.points[1].x - 3, triangle.points[1].y - 3, 6, 6, 0xFFFF0000); // vertex B
-            draw_rect(triangle.points[2].x - 3, triangle.points[2].y - 3, 6, 6, 0xFFFF0000); // vertex C
+    // The edge rasterizer draws screen tiles in parallel, the scanline one draws the whole window at once
+    triangle_t* triangles_to_render = frame->triangles_to_render;
+    uint32_t* render_order = frame->render_order;
+    int num_triangles = array_length(triangles_to_render);
+    if (raster_method == RASTER_EDGE && use_tile_binning && job_threads > 1) {
+        binner_draw(&frame->arena, triangles_to_render, render_order, num_triangles, VERTEX_MARKER_MARGIN, draw_render_triangle);
+    } else {
+        rect_t clip = window_rect();
+        for (int i = 0; i < num_triangles; i++) {
+            draw_render_triangle(&triangles_to_render[render_order != NULL ? render_order[i] : i], clip);
         }
     }
 
-    // Clear the array of triangles to render every frame loop
-    array_free(triangles_to_render);
-
     render_color_buffer();
 
     clear_color_buffer(0xFF000000);
 
+    // Present and wait as the frame pacing asks, which the stats report apart from the frame's work
+    Uint64 present_start = SDL_GetPerformanceCounter();
     SDL_RenderPresent(renderer);
+    wait_for_next_frame();
+    frame_stats.present_time += SDL_GetPerformanceCounter() - present_start;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Build and draw a frame. When pipelining, the job threads build the next
+// frame while this one is drawn, so geometry and raster overlap, and camera
+// moves show up one frame later. Frames are never built more than one ahead,
+// and settings changes rebuild the frame built ahead so they show up at once.
+///////////////////////////////////////////////////////////////////////////////
+void run_frame(void) {
+    frame_t* frame = &frames[current_frame];
+    if (!next_frame_built) {
+        update();
+        build_frame(frame);
+    } else if (settings_changed) {
+        // Rebuild the frame built ahead with the new settings and the camera as it is now
+        view_matrix = camera_view_matrix();
+        build_frame(frame);
+    }
+    settings_changed = false;
+    next_frame_built = false;
+
+    if (!use_pipelining || job_threads == 1) {
+        render(frame);
+        return;
+    }
+
+    // The scene, camera, and settings stay as they are until the next frame is built
+    update();
+    frame_t* next_frame = &frames[1 - current_frame];
+    job_t job = { build_frame_job, next_frame, 0, 1, NULL };
+    job_counter_t next_frame_done;
+    SDL_AtomicSet(&next_frame_done.pending, 0);
+    job_submit(&job, 1, &next_frame_done);
+    render(frame);
+    job_wait(&next_frame_done);
+    current_frame = 1 - current_frame;
+    next_frame_built = true;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -318,22 +750,65 @@ void render(void) {
 ///////////////////////////////////////////////////////////////////////////////
 void free_resources(void) {
     free(color_buffer);
-    array_free(mesh.faces);
-    array_free(mesh.vertices);
+    free(z_buffer);
+    free(depth_tiles);
+    free(clip_vertices);
+    free(projected_vertices);
+    free(clip_codes);
+    free_scene();
+    for (int i = 0; i < job_threads; i++) {
+        arena_free(&geometry_arenas[i]);
+    }
+    free(geometry_arenas);
+    job_system_free();
+    for (int i = 0; i < 2; i++) {
+        arena_free(&frames[i].arena);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Read the command line options, returning false on an invalid one
+///////////////////////////////////////////////////////////////////////////////
+bool parse_arguments(int argc, char* argv[]) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            num_job_threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--pin") == 0) {
+            pin_job_threads = true;
+        } else if (strcmp(argv[i], "--no-pipeline") == 0) {
+            use_pipelining = false;
+        } else if (strcmp(argv[i], "--vsync") == 0) {
+            frame_pacing = PACING_VSYNC;
+        } else if (strcmp(argv[i], "--uncapped") == 0) {
+            frame_pacing = PACING_UNCAPPED;
+        } else if (strcmp(argv[i], "--fps") == 0 && i + 1 < argc) {
+            frame_pacing = PACING_TARGET_RATE;
+            target_frame_rate = atoi(argv[++i]);
+        } else {
+            printf("Usage: %s [--threads count] [--pin] [--no-pipeline] [--vsync | --uncapped | --fps rate]\n", argv[0]);
+            return false;
+        }
+    }
+    return true;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 // Main function
 ///////////////////////////////////////////////////////////////////////////////
-int main(void) {
+int main(int argc, char* argv[]) {
+    if (!parse_arguments(argc, argv)) {
+        return 1;
+    }
+
     is_running = initialize_window();
 
     setup();
 
     while (is_running) {
+        stats_begin_frame();
         process_input();
-        update();
-        render();
+        run_frame();
+        stats_end_frame();
     }
 
     destroy_window();
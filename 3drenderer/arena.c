@@ -0,0 +1,116 @@
+#include <stdlib.h>
+#include <string.h>
+#include "arena.h"
+
+#define ARENA_ALIGNMENT 16
+
+static size_t align_up(size_t value) {
+    return (value + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+}
+
+static arena_block_t* arena_block_create(size_t size, arena_block_t* next) {
+    arena_block_t* block = (arena_block_t*)malloc(align_up(sizeof(arena_block_t)) + size);
+    block->next = next;
+    block->size = size;
+    block->used = 0;
+    block->data = (char*)block + align_up(sizeof(arena_block_t));
+    return block;
+}
+
+void arena_init(arena_t* arena, size_t capacity) {
+    arena->block = arena_block_create(align_up(capacity), NULL);
+    arena->last_allocation = NULL;
+    arena->used = 0;
+    arena->high_water_mark = 0;
+    arena->heap_allocations = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Bump the current block, or chain a bigger one if the request doesn't fit
+///////////////////////////////////////////////////////////////////////////////
+void* arena_alloc(arena_t* arena, size_t size) {
+    size = align_up(size);
+    arena_block_t* block = arena->block;
+    if (block->used + size > block->size) {
+        size_t block_size = block->size * 2;
+        while (block_size < size) {
+            block_size *= 2;
+        }
+        block = arena_block_create(block_size, block);
+        arena->block = block;
+        arena->heap_allocations++;
+    }
+
+    void* ptr = block->data + block->used;
+    block->used += size;
+    arena->used += size;
+    if (arena->used > arena->high_water_mark) {
+        arena->high_water_mark = arena->used;
+    }
+    arena->last_allocation = ptr;
+    return ptr;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Grow an allocation, in place when it is the most recent one and still fits
+///////////////////////////////////////////////////////////////////////////////
+void* arena_resize(arena_t* arena, void* ptr, size_t old_size, size_t new_size) {
+    if (ptr != NULL && new_size <= old_size) {
+        return ptr;
+    }
+    arena_block_t* block = arena->block;
+    if (ptr != NULL && ptr == arena->last_allocation) {
+        size_t offset = (char*)ptr - block->data;
+        size_t grow = align_up(new_size) - align_up(old_size);
+        if (offset + align_up(new_size) <= block->size) {
+            block->used += grow;
+            arena->used += grow;
+            if (arena->used > arena->high_water_mark) {
+                arena->high_water_mark = arena->used;
+            }
+            return ptr;
+        }
+    }
+
+    void* new_ptr = arena_alloc(arena, new_size);
+    if (ptr != NULL) {
+        memcpy(new_ptr, ptr, old_size);
+    }
+    return new_ptr;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Release everything at once. If the last frame needed more than one block,
+// they are merged into a single block with the combined capacity.
+///////////////////////////////////////////////////////////////////////////////
+void arena_reset(arena_t* arena) {
+    arena->heap_allocations = 0;
+    if (arena->block->next != NULL) {
+        size_t capacity = arena_capacity(arena);
+        arena_free(arena);
+        arena->block = arena_block_create(capacity, NULL);
+        arena->heap_allocations++;
+    }
+    arena->block->used = 0;
+    arena->last_allocation = NULL;
+    arena->used = 0;
+}
+
+size_t arena_capacity(arena_t* arena) {
+    size_t capacity = 0;
+    for (arena_block_t* block = arena->block; block != NULL; block = block->next) {
+        capacity += block->size;
+    }
+    return capacity;
+}
+
+void arena_free(arena_t* arena) {
+    arena_block_t* block = arena->block;
+    while (block != NULL) {
+        arena_block_t* next = block->next;
+        free(block);
+        block = next;
+    }
+    arena->block = NULL;
+    arena->last_allocation = NULL;
+}
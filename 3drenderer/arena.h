@@ -0,0 +1,32 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+////////////////////////////////////////////////////////////////////////////////
+// Bump allocator for transient data, reset at the start of every frame. The
+// capacity is kept across resets, so steady-state frames never touch the heap.
+////////////////////////////////////////////////////////////////////////////////
+typedef struct arena_block {
+    struct arena_block* next; // previously filled block, NULL for the first one
+    size_t size;              // usable bytes in data
+    size_t used;              // bytes handed out from data
+    char* data;               // start of the usable bytes
+} arena_block_t;
+
+typedef struct {
+    arena_block_t* block;     // block new allocations come from
+    void* last_allocation;    // most recent allocation, which can grow in place
+    size_t used;              // bytes handed out since the last reset
+    size_t high_water_mark;   // largest value of used across all frames
+    int heap_allocations;     // blocks malloc'd since the last reset
+} arena_t;
+
+void arena_init(arena_t* arena, size_t capacity);
+void* arena_alloc(arena_t* arena, size_t size);
+void* arena_resize(arena_t* arena, void* ptr, size_t old_size, size_t new_size);
+void arena_reset(arena_t* arena);
+size_t arena_capacity(arena_t* arena);
+void arena_free(arena_t* arena);
+
+#endif
@@ -29,6 +29,26 @@ void* array_hold(void* array, int count, int item_size) {
     }
 }
 
+void* array_hold_arena(arena_t* arena, void* array, int count, int item_size) {
+    if (array != NULL && ARRAY_OCCUPIED(array) + count <= ARRAY_CAPACITY(array)) {
+        ARRAY_OCCUPIED(array) += count;
+        return array;
+    }
+
+    // Grow the same way as array_hold, letting the arena extend the block in place if it can
+    int occupied = (array != NULL) ? ARRAY_OCCUPIED(array) : 0;
+    int old_capacity = (array != NULL) ? ARRAY_CAPACITY(array) : 0;
+    int needed_size = occupied + count;
+    int float_curr = old_capacity * 2;
+    int capacity = needed_size > float_curr ? needed_size : float_curr;
+    int old_raw_size = sizeof(int) * 2 + item_size * old_capacity;
+    int raw_size = sizeof(int) * 2 + item_size * capacity;
+    int* base = (int*)arena_resize(arena, (array != NULL) ? ARRAY_RAW_DATA(array) : NULL, old_raw_size, raw_size);
+    base[0] = capacity;
+    base[1] = needed_size;
+    return base + 2;
+}
+
 int array_length(void* array) {
     return (array != NULL) ? ARRAY_OCCUPIED(array) : 0;
 }
@@ -1,13 +1,26 @@
 #ifndef ARRAY_H
 #define ARRAY_H
 
+#include "arena.h"
+
 #define array_push(array, value)                                              \
     do {                                                                      \
         (array) = array_hold((array), 1, sizeof(*(array)));                   \
         (array)[array_length(array) - 1] = (value);                           \
     } while (0);
 
+////////////////////////////////////////////////////////////////////////////////
+// Same as array_push but the storage comes from an arena, so it must never be
+// passed to array_free; it is released when the arena is reset
+////////////////////////////////////////////////////////////////////////////////
+#define array_push_arena(arena, array, value)                                 \
+    do {                                                                      \
+        (array) = array_hold_arena((arena), (array), 1, sizeof(*(array)));    \
+        (array)[array_length(array) - 1] = (value);                           \
+    } while (0);
+
 void* array_hold(void* array, int count, int item_size);
+void* array_hold_arena(arena_t* arena, void* array, int count, int item_size);
 int array_length(void* array);
 void array_free(void* array);
 
@@ -0,0 +1,130 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL2/SDL.h>
+#include "binner.h"
+#include "job.h"
+#include "stats.h"
+
+bool use_tile_binning = true;
+
+///////////////////////////////////////////////////////////////////////////////
+// The triangles of a frame sorted into screen tiles. Each bin lists the
+// triangles overlapping its tile in drawing order, as indices into triangles.
+///////////////////////////////////////////////////////////////////////////////
+typedef struct {
+    triangle_t* triangles;
+    uint32_t* bin_triangles;  // the bins one after the other
+    int* bin_start;           // offset of each bin in bin_triangles, plus the total at the end
+    int tiles_x, tiles_y;
+    bin_draw_function_t draw;
+} bin_pass_t;
+
+static bin_pass_t pass;
+
+///////////////////////////////////////////////////////////////////////////////
+// Job drawing the tiles from start to end, every triangle of a tile in its bin
+// order clipped to the tile. Tiles never share pixels or depth tiles, so the
+// jobs need no locking, and each pixel sees the same draws in the same order
+// whichever thread runs its tile.
+///////////////////////////////////////////////////////////////////////////////
+static void draw_bins(void* data, int start, int end) {
+    (void)data;
+    for (int tile = start; tile < end; tile++) {
+        int x = (tile % pass.tiles_x) * BIN_TILE_SIZE;
+        int y = (tile / pass.tiles_x) * BIN_TILE_SIZE;
+        rect_t clip = {
+            x, y,
+            (x + BIN_TILE_SIZE < window_width) ? x + BIN_TILE_SIZE - 1 : window_width - 1,
+            (y + BIN_TILE_SIZE < window_height) ? y + BIN_TILE_SIZE - 1 : window_height - 1
+        };
+        for (int i = pass.bin_start[tile]; i < pass.bin_start[tile + 1]; i++) {
+            pass.draw(&pass.triangles[pass.bin_triangles[i]], clip);
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Range of tiles covered by the coordinates from min to max along an axis
+// with the given number of pixels, or false when the range is off screen
+///////////////////////////////////////////////////////////////////////////////
+static bool tile_range(float min, float max, int margin, int pixels, int* first, int* last) {
+    min = floorf(min) - margin;
+    max = ceilf(max) + margin;
+    if (!(max >= 0 && min <= pixels - 1)) {
+        return false;
+    }
+    *first = (min > 0) ? (int)min / BIN_TILE_SIZE : 0;
+    *last = (max < pixels - 1) ? (int)max / BIN_TILE_SIZE : (pixels - 1) / BIN_TILE_SIZE;
+    return true;
+}
+
+static bool triangle_tiles(triangle_t* triangle, int margin, int* tile_x0, int* tile_y0, int* tile_x1, int* tile_y1) {
+    vec4_t* p = triangle->points;
+    float x_min = fminf(fminf(p[0].x, p[1].x), p[2].x);
+    float x_max = fmaxf(fmaxf(p[0].x, p[1].x), p[2].x);
+    float y_min = fminf(fminf(p[0].y, p[1].y), p[2].y);
+    float y_max = fmaxf(fmaxf(p[0].y, p[1].y), p[2].y);
+    return tile_range(x_min, x_max, margin, window_width, tile_x0, tile_x1) &&
+           tile_range(y_min, y_max, margin, window_height, tile_y0, tile_y1);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Draw the triangles in order (or in the order given by order when not NULL)
+// over screen tiles of BIN_TILE_SIZE pixels, on all the job threads. Each
+// triangle goes to every tile its vertices, grown by margin pixels, overlap.
+// The bins are counted first and then filled, in arrays from the arena.
+///////////////////////////////////////////////////////////////////////////////
+void binner_draw(arena_t* arena, triangle_t* triangles, uint32_t* order, int count, int margin, bin_draw_function_t draw) {
+    Uint64 pass_start = SDL_GetPerformanceCounter();
+
+    pass.triangles = triangles;
+    pass.draw = draw;
+    pass.tiles_x = (window_width + BIN_TILE_SIZE - 1) / BIN_TILE_SIZE;
+    pass.tiles_y = (window_height + BIN_TILE_SIZE - 1) / BIN_TILE_SIZE;
+    int num_tiles = pass.tiles_x * pass.tiles_y;
+    pass.bin_start = (int*)arena_alloc(arena, sizeof(int) * (num_tiles + 1));
+    memset(pass.bin_start, 0, sizeof(int) * (num_tiles + 1));
+
+    // Count the triangles of every bin, then turn the counts into offsets
+    for (int i = 0; i < count; i++) {
+        int tile_x0, tile_y0, tile_x1, tile_y1;
+        if (triangle_tiles(&triangles[order != NULL ? order[i] : (uint32_t)i], margin, &tile_x0, &tile_y0, &tile_x1, &tile_y1)) {
+            for (int tile_y = tile_y0; tile_y <= tile_y1; tile_y++) {
+                for (int tile_x = tile_x0; tile_x <= tile_x1; tile_x++) {
+                    pass.bin_start[pass.tiles_x * tile_y + tile_x]++;
+                }
+            }
+        }
+    }
+    int offset = 0;
+    for (int tile = 0; tile <= num_tiles; tile++) {
+        int bin_count = pass.bin_start[tile];
+        pass.bin_start[tile] = offset;
+        offset += bin_count;
+    }
+
+    // Fill the bins in drawing order, moving each start to the end of its bin, then back
+    pass.bin_triangles = (uint32_t*)arena_alloc(arena, sizeof(uint32_t) * offset);
+    for (int i = 0; i < count; i++) {
+        uint32_t index = order != NULL ? order[i] : (uint32_t)i;
+        int tile_x0, tile_y0, tile_x1, tile_y1;
+        if (triangle_tiles(&triangles[index], margin, &tile_x0, &tile_y0, &tile_x1, &tile_y1)) {
+            for (int tile_y = tile_y0; tile_y <= tile_y1; tile_y++) {
+                for (int tile_x = tile_x0; tile_x <= tile_x1; tile_x++) {
+                    pass.bin_triangles[pass.bin_start[pass.tiles_x * tile_y + tile_x]++] = index;
+                }
+            }
+        }
+    }
+    for (int tile = num_tiles; tile > 0; tile--) {
+        pass.bin_start[tile] = pass.bin_start[tile - 1];
+    }
+    pass.bin_start[0] = 0;
+    frame_stats.triangles_binned += offset;
+
+    // Draw the tiles on all the job threads, with stealing evening out busy tiles
+    job_parallel_for(num_tiles, 1, draw_bins, NULL);
+    frame_stats.tile_pass_time += SDL_GetPerformanceCounter() - pass_start;
+}
@@ -0,0 +1,29 @@
+#ifndef BINNER_H
+#define BINNER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "arena.h"
+#include "display.h"
+#include "raster.h"
+#include "triangle.h"
+
+// Side of the square screen tiles. A multiple of the depth tiles, the SIMD
+// groups, and the affine segments, so none of them straddles two tiles.
+#define BIN_TILE_SIZE 64
+
+#if BIN_TILE_SIZE % DEPTH_TILE_SIZE != 0 || BIN_TILE_SIZE % RASTER_AFFINE_SPAN != 0 || BIN_TILE_SIZE % RASTER_SIMD_WIDTH != 0
+#error "BIN_TILE_SIZE must be a multiple of the depth tiles, affine segments, and SIMD width"
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// Draws one triangle of the frame, writing only inside the clip rectangle.
+// Called from several threads at once, always with disjoint rectangles.
+////////////////////////////////////////////////////////////////////////////////
+typedef void (*bin_draw_function_t)(triangle_t* triangle, rect_t clip);
+
+extern bool use_tile_binning;
+
+void binner_draw(arena_t* arena, triangle_t* triangles, uint32_t* order, int count, int margin, bin_draw_function_t draw);
+
+#endif
@@ -0,0 +1,41 @@
+#include "camera.h"
+
+#define MAX_CAMERA_PITCH 1.5
+
+camera_t camera = {
+    .position = { 0, 0, 0 },
+    .direction = { 0, 0, 1 },
+    .yaw = 0,
+    .pitch = 0
+};
+
+static const vec3_t camera_up = { 0, 1, 0 };
+
+///////////////////////////////////////////////////////////////////////////////
+// Turn the camera, keeping the pitch short of straight up or down so the view
+// direction never lines up with the up vector
+///////////////////////////////////////////////////////////////////////////////
+void camera_rotate(float yaw_delta, float pitch_delta) {
+    camera.yaw += yaw_delta;
+    camera.pitch += pitch_delta;
+    if (camera.pitch > MAX_CAMERA_PITCH) camera.pitch = MAX_CAMERA_PITCH;
+    if (camera.pitch < -MAX_CAMERA_PITCH) camera.pitch = -MAX_CAMERA_PITCH;
+
+    vec3_t forward = { 0, 0, 1 };
+    camera.direction = vec3_rotate_y(vec3_rotate_x(forward, -camera.pitch), camera.yaw);
+}
+
+void camera_move_forward(float distance) {
+    camera.position = vec3_add(camera.position, vec3_mul(camera.direction, distance));
+}
+
+void camera_move_right(float distance) {
+    vec3_t right = vec3_cross(camera_up, camera.direction);
+    vec3_normalize(&right);
+    camera.position = vec3_add(camera.position, vec3_mul(right, distance));
+}
+
+mat4_t camera_view_matrix(void) {
+    vec3_t target = vec3_add(camera.position, camera.direction);
+    return mat4_look_at(camera.position, target, camera_up);
+}
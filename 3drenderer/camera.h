@@ -0,0 +1,25 @@
+#ifndef CAMERA_H
+#define CAMERA_H
+
+#include "vector.h"
+#include "matrix.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// First person camera, looking along direction from position. The direction is
+// derived from the yaw (around y) and pitch (around x) angles in radians.
+////////////////////////////////////////////////////////////////////////////////
+typedef struct {
+    vec3_t position;
+    vec3_t direction;
+    float yaw;
+    float pitch;
+} camera_t;
+
+extern camera_t camera;
+
+void camera_rotate(float yaw_delta, float pitch_delta);
+void camera_move_forward(float distance);
+void camera_move_right(float distance);
+mat4_t camera_view_matrix(void);
+
+#endif
@@ -0,0 +1,192 @@
+#include <math.h>
+#include "clipping.h"
+#include "transform.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Extract the view space frustum planes from the rows of the projection matrix
+// (Gribb/Hartmann). Each clip space test, such as -w <= x, turns into a plane
+// by adding or subtracting matrix rows.
+///////////////////////////////////////////////////////////////////////////////
+void init_frustum_planes(mat4_t proj_matrix, plane_t planes[NUM_FRUSTUM_PLANES]) {
+    float (*m)[4] = proj_matrix.m;
+    float rows[NUM_FRUSTUM_PLANES][4];
+    for (int j = 0; j < 4; j++) {
+        rows[0][j] = m[3][j] + m[0][j]; // left:   x >= -w
+        rows[1][j] = m[3][j] - m[0][j]; // right:  x <= w
+        rows[2][j] = m[3][j] - m[1][j]; // top:    y <= w
+        rows[3][j] = m[3][j] + m[1][j]; // bottom: y >= -w
+        rows[4][j] = m[2][j];           // near:   z >= 0
+        rows[5][j] = m[3][j] - m[2][j]; // far:    z <= w
+    }
+    for (int i = 0; i < NUM_FRUSTUM_PLANES; i++) {
+        vec3_t normal = { rows[i][0], rows[i][1], rows[i][2] };
+        float length = vec3_length(normal);
+        planes[i].normal = vec3_div(normal, length);
+        planes[i].distance = rows[i][3] / length;
+    }
+}
+
+bool sphere_outside_frustum(plane_t planes[NUM_FRUSTUM_PLANES], vec3_t center, float radius) {
+    for (int i = 0; i < NUM_FRUSTUM_PLANES; i++) {
+        if (vec3_dot(planes[i].normal, center) + planes[i].distance < -radius) {
+            return true;
+        }
+    }
+    return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Transform the eight box corners into clip space and test if all of them lie
+// outside the same plane
+///////////////////////////////////////////////////////////////////////////////
+bool aabb_outside_frustum(mat4_t clip_matrix, vec3_t min, vec3_t max) {
+    uint8_t outside_all = 0xFF;
+    for (int i = 0; i < 8; i++) {
+        vec4_t corner = {
+            (i & 1) ? max.x : min.x,
+            (i & 2) ? max.y : min.y,
+            (i & 4) ? max.z : min.z,
+            1.0
+        };
+        outside_all &= clip_outcode(mat4_mul_vec4(clip_matrix, corner));
+        if (outside_all == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint8_t clip_outcode(vec4_t v) {
+    uint8_t code = 0;
+    if (v.x < -v.w) code |= CLIP_LEFT;
+    if (v.x > v.w) code |= CLIP_RIGHT;
+    if (v.y > v.w) code |= CLIP_TOP;
+    if (v.y < -v.w) code |= CLIP_BOTTOM;
+    if (v.z < 0) code |= CLIP_NEAR;
+    if (v.z > v.w) code |= CLIP_FAR;
+    return code;
+}
+
+polygon_t create_polygon_from_triangle(vec4_t v0, vec4_t v1, vec4_t v2, tex2_t t0, tex2_t t1, tex2_t t2) {
+    polygon_t polygon = {
+        .vertices = { v0, v1, v2 },
+        .texcoords = { t0, t1, t2 },
+        .num_vertices = 3
+    };
+    return polygon;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Signed distance of a clip space vertex to one of the frustum planes,
+// positive inside. In clip space every plane is a plane through w.
+///////////////////////////////////////////////////////////////////////////////
+static float plane_distance(vec4_t v, uint8_t plane) {
+    switch (plane) {
+        case CLIP_LEFT: return v.w + v.x;
+        case CLIP_RIGHT: return v.w - v.x;
+        case CLIP_TOP: return v.w - v.y;
+        case CLIP_BOTTOM: return v.w + v.y;
+        case CLIP_NEAR: return v.z;
+        default: return v.w - v.z;
+    }
+}
+
+static float float_lerp(float a, float b, float t) {
+    return a + t * (b - a);
+}
+
+static vec4_t vec4_lerp(vec4_t a, vec4_t b, float t) {
+    vec4_t result = {
+        float_lerp(a.x, b.x, t),
+        float_lerp(a.y, b.y, t),
+        float_lerp(a.z, b.z, t),
+        float_lerp(a.w, b.w, t)
+    };
+    return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Sutherland-Hodgman against a single plane. Attributes are interpolated
+// linearly, which is perspective correct because we are still before the divide.
+///////////////////////////////////////////////////////////////////////////////
+static void clip_polygon_against_plane(polygon_t* polygon, uint8_t plane) {
+    vec4_t inside_vertices[MAX_NUM_POLY_VERTICES];
+    tex2_t inside_texcoords[MAX_NUM_POLY_VERTICES];
+    int num_inside_vertices = 0;
+
+    int previous = polygon->num_vertices - 1;
+    float previous_distance = plane_distance(polygon->vertices[previous], plane);
+
+    for (int current = 0; current < polygon->num_vertices; current++) {
+        float current_distance = plane_distance(polygon->vertices[current], plane);
+
+        // Emit the intersection point when the edge crosses the plane
+        if ((current_distance >= 0) != (previous_distance >= 0)) {
+            float t = previous_distance / (previous_distance - current_distance);
+            tex2_t previous_uv = polygon->texcoords[previous];
+            tex2_t current_uv = polygon->texcoords[current];
+            inside_vertices[num_inside_vertices] = vec4_lerp(polygon->vertices[previous], polygon->vertices[current], t);
+            inside_texcoords[num_inside_vertices] = (tex2_t){
+                float_lerp(previous_uv.u, current_uv.u, t),
+                float_lerp(previous_uv.v, current_uv.v, t)
+            };
+            num_inside_vertices++;
+        }
+
+        // Keep the current vertex when it is inside
+        if (current_distance >= 0) {
+            inside_vertices[num_inside_vertices] = polygon->vertices[current];
+            inside_texcoords[num_inside_vertices] = polygon->texcoords[current];
+            num_inside_vertices++;
+        }
+
+        previous = current;
+        previous_distance = current_distance;
+    }
+
+    for (int i = 0; i < num_inside_vertices; i++) {
+        polygon->vertices[i] = inside_vertices[i];
+        polygon->texcoords[i] = inside_texcoords[i];
+    }
+    polygon->num_vertices = num_inside_vertices;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Clip the polygon against each frustum plane flagged in planes
+///////////////////////////////////////////////////////////////////////////////
+void clip_polygon(polygon_t* polygon, uint8_t planes) {
+    for (uint8_t plane = CLIP_LEFT; plane <= CLIP_FAR; plane <<= 1) {
+        if (planes & plane) {
+            clip_polygon_against_plane(polygon, plane);
+            if (polygon->num_vertices < 3) {
+                polygon->num_vertices = 0;
+                return;
+            }
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Project the clipped polygon and break it into a triangle fan around vertex 0.
+// Only points and texcoords are filled in; the caller sets color and depth.
+///////////////////////////////////////////////////////////////////////////////
+int triangles_from_polygon(polygon_t* polygon, triangle_t triangles[MAX_NUM_POLY_TRIANGLES]) {
+    vec4_t projected_points[MAX_NUM_POLY_VERTICES];
+    for (int i = 0; i < polygon->num_vertices; i++) {
+        projected_points[i] = clip_to_screen(polygon->vertices[i]);
+    }
+
+    int num_triangles = polygon->num_vertices - 2;
+    for (int i = 0; i < num_triangles; i++) {
+        int index0 = 0;
+        int index1 = i + 1;
+        int index2 = i + 2;
+        triangles[i].points[0] = projected_points[index0];
+        triangles[i].points[1] = projected_points[index1];
+        triangles[i].points[2] = projected_points[index2];
+        triangles[i].texcoords[0] = polygon->texcoords[index0];
+        triangles[i].texcoords[1] = polygon->texcoords[index1];
+        triangles[i].texcoords[2] = polygon->texcoords[index2];
+    }
+    return num_triangles > 0 ? num_triangles : 0;
+}
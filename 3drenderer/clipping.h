@@ -0,0 +1,54 @@
+#ifndef CLIPPING_H
+#define CLIPPING_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "matrix.h"
+#include "texture.h"
+#include "triangle.h"
+#include "vector.h"
+
+#define MAX_NUM_POLY_VERTICES 10
+#define MAX_NUM_POLY_TRIANGLES (MAX_NUM_POLY_VERTICES - 2)
+
+////////////////////////////////////////////////////////////////////////////////
+// Outcode bits, one per frustum plane, set when a clip space vertex is outside
+////////////////////////////////////////////////////////////////////////////////
+enum {
+    CLIP_LEFT = 1 << 0,   // x < -w
+    CLIP_RIGHT = 1 << 1,  // x > w
+    CLIP_TOP = 1 << 2,    // y > w
+    CLIP_BOTTOM = 1 << 3, // y < -w
+    CLIP_NEAR = 1 << 4,   // z < 0
+    CLIP_FAR = 1 << 5     // z > w
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Convex polygon in homogeneous clip space, before the perspective divide
+////////////////////////////////////////////////////////////////////////////////
+typedef struct {
+    vec4_t vertices[MAX_NUM_POLY_VERTICES];
+    tex2_t texcoords[MAX_NUM_POLY_VERTICES];
+    int num_vertices;
+} polygon_t;
+
+////////////////////////////////////////////////////////////////////////////////
+// View space plane as normal and distance, with dot(normal, p) + distance >= 0 inside
+////////////////////////////////////////////////////////////////////////////////
+#define NUM_FRUSTUM_PLANES 6
+
+typedef struct {
+    vec3_t normal;
+    float distance;
+} plane_t;
+
+void init_frustum_planes(mat4_t proj_matrix, plane_t planes[NUM_FRUSTUM_PLANES]);
+bool sphere_outside_frustum(plane_t planes[NUM_FRUSTUM_PLANES], vec3_t center, float radius);
+bool aabb_outside_frustum(mat4_t clip_matrix, vec3_t min, vec3_t max);
+
+uint8_t clip_outcode(vec4_t clip_vertex);
+polygon_t create_polygon_from_triangle(vec4_t v0, vec4_t v1, vec4_t v2, tex2_t t0, tex2_t t1, tex2_t t2);
+void clip_polygon(polygon_t* polygon, uint8_t planes);
+int triangles_from_polygon(polygon_t* polygon, triangle_t triangles[MAX_NUM_POLY_TRIANGLES]);
+
+#endif
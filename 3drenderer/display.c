@@ -1,12 +1,22 @@
 #include <stdio.h>
 #include "display.h"
+#include "job.h"
+#include "stats.h"
+#include "swap.h"
 
 SDL_Window* window = NULL;
 SDL_Renderer* renderer = NULL;
 uint32_t* color_buffer = NULL;
+float* z_buffer = NULL;
+depth_tile_t* depth_tiles = NULL;
+bool use_depth_tiles = true;
 SDL_Texture* color_buffer_texture = NULL;
 int window_width = 800;
 int window_height = 600;
+int target_frame_rate = 90;
+
+// When the last frame was due with PACING_TARGET_RATE, in performance counter ticks
+static Uint64 frame_deadline = 0;
 
 bool initialize_window(void) {
     if (SDL_Init(SDL_INIT_EVERYTHING) != 0) {
@@ -44,6 +54,11 @@ bool initialize_window(void) {
     return true;
 }
 
+rect_t window_rect(void) {
+    rect_t rect = { 0, 0, window_width - 1, window_height - 1 };
+    return rect;
+}
+
 void draw_grid(void) {
     for (int y = 0; y < window_height; y += 10) {
         for (int x = 0; x < window_width; x += 10) {
@@ -58,31 +73,242 @@ void draw_pixel(int x, int y, uint32_t color) {
     }
 }
 
-void draw_line(int x0, int y0, int x1, int y1, uint32_t color) {
-    int delta_x = (x1 - x0);
-    int delta_y = (y1 - y0);
+///////////////////////////////////////////////////////////////////////////////
+// Ceiling of a / b for a positive b and any sign of a
+///////////////////////////////////////////////////////////////////////////////
+static int64_t ceil_div(int64_t a, int64_t b) {
+    return (a >= 0) ? (a + b - 1) / b : -((-a) / b);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Narrow the steps [first, last] of a line to those whose coordinate along
+// one axis, start + sign * floor((2 * i * delta + steps) / (2 * steps)), lies
+// inside [min, max]. The major axis is the case delta == steps.
+///////////////////////////////////////////////////////////////////////////////
+static void clip_line_steps(int start, int sign, int delta, int steps, int min, int max, int64_t* first, int64_t* last) {
+    // Range of offsets from the start that stay inside the clip rectangle
+    int64_t low = (sign > 0) ? (int64_t)min - start : (int64_t)start - max;
+    int64_t high = (sign > 0) ? (int64_t)max - start : (int64_t)start - min;
+
+    if (delta == 0) {
+        // The coordinate never moves, so the line is either all in or all out
+        if (low > 0 || high < 0) {
+            *last = *first - 1;
+        }
+        return;
+    }
+
+    // The offset is a non-decreasing function of i, so each bound gives one step
+    int64_t i_low = ceil_div((2 * low - 1) * steps, 2 * (int64_t)delta);
+    int64_t i_high = ceil_div((2 * high + 1) * steps, 2 * (int64_t)delta) - 1;
+    if (i_low > *first) *first = i_low;
+    if (i_high < *last) *last = i_high;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Draw a line with the integer Bresenham algorithm. The line is clipped to the
+// rectangle up front by solving for the first and last visible step along each
+// axis, so the loop only visits pixels inside and needs no bounds checks.
+// The clipped line covers exactly the pixels the full line would have drawn,
+// and lines are always stepped from their top endpoint so that drawing an
+// edge in either direction lights the same pixels.
+///////////////////////////////////////////////////////////////////////////////
+void draw_line(int x0, int y0, int x1, int y1, uint32_t color, rect_t clip) {
+    if (y1 < y0 || (y1 == y0 && x1 < x0)) {
+        int_swap(&x0, &x1);
+        int_swap(&y0, &y1);
+    }
+
+    int delta_x = abs(x1 - x0);
+    int delta_y = abs(y1 - y0);
+    int sign_x = (x1 >= x0) ? 1 : -1;
+    int sign_y = (y1 >= y0) ? 1 : -1;
+
+    // Step one pixel at a time along the longest side of the line
+    bool x_major = (delta_x >= delta_y);
+    int steps = x_major ? delta_x : delta_y;
+    int delta_minor = x_major ? delta_y : delta_x;
+    int major_stride = x_major ? sign_x : sign_y * window_width;
+    int minor_stride = x_major ? sign_y * window_width : sign_x;
+
+    int64_t first = 0;
+    int64_t last = steps;
+    clip_line_steps(x0, sign_x, delta_x, steps, clip.x_min, clip.x_max, &first, &last);
+    clip_line_steps(y0, sign_y, delta_y, steps, clip.y_min, clip.y_max, &first, &last);
+    if (first > last) {
+        return;
+    }
+
+    // Minor axis offset and remainder of the first visible step
+    int64_t numerator = 2 * first * delta_minor + steps;
+    int64_t minor_offset = (steps > 0) ? numerator / (2 * (int64_t)steps) : 0;
+    int64_t error = numerator - minor_offset * 2 * steps;
+
+    int64_t first_x = x0 + sign_x * (x_major ? first : minor_offset);
+    int64_t first_y = y0 + sign_y * (x_major ? minor_offset : first);
+    uint32_t* pixel = &color_buffer[(window_width * first_y) + first_x];
+
+    int64_t error_step = 2 * (int64_t)delta_minor;
+    int64_t error_wrap = 2 * (int64_t)steps;
+    for (int64_t i = first; i < last; i++) {
+        *pixel = color;
+        error += error_step;
+        int64_t wrap = -(int64_t)(error >= error_wrap);
+        error -= error_wrap & wrap;
+        pixel += major_stride + (minor_stride & wrap);
+    }
+    *pixel = color;
+}
+
+void draw_rect(int x, int y, int width, int height, uint32_t color, rect_t clip) {
+    int x_start = (x > clip.x_min) ? x : clip.x_min;
+    int y_start = (y > clip.y_min) ? y : clip.y_min;
+    int x_end = (x + width - 1 < clip.x_max) ? x + width - 1 : clip.x_max;
+    int y_end = (y + height - 1 < clip.y_max) ? y + height - 1 : clip.y_max;
+    for (int current_y = y_start; current_y <= y_end; current_y++) {
+        for (int current_x = x_start; current_x <= x_end; current_x++) {
+            color_buffer[(window_width * current_y) + current_x] = color;
+        }
+    }
+}
+
+static int depth_tiles_per_row(void) {
+    return (window_width + DEPTH_TILE_SIZE - 1) / DEPTH_TILE_SIZE;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Recompute the farthest depth of a tile from the pixels inside the window
+///////////////////////////////////////////////////////////////////////////////
+static void refresh_depth_tile(depth_tile_t* tile, int tile_x, int tile_y) {
+    int x_start = tile_x * DEPTH_TILE_SIZE;
+    int y_start = tile_y * DEPTH_TILE_SIZE;
+    int x_end = (x_start + DEPTH_TILE_SIZE < window_width) ? x_start + DEPTH_TILE_SIZE : window_width;
+    int y_end = (y_start + DEPTH_TILE_SIZE < window_height) ? y_start + DEPTH_TILE_SIZE : window_height;
+
+    float farthest = z_buffer[(window_width * y_start) + x_start];
+    for (int y = y_start; y < y_end; y++) {
+        for (int x = x_start; x < x_end; x++) {
+            float depth = z_buffer[(window_width * y) + x];
+            if (depth < farthest) {
+                farthest = depth;
+            }
+        }
+    }
+    tile->farthest = farthest;
+    tile->dirty = false;
+}
+
+void mark_depth_tile_dirty(int x, int y) {
+    depth_tiles[depth_tiles_per_row() * (y / DEPTH_TILE_SIZE) + (x / DEPTH_TILE_SIZE)].dirty = true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Depth test a pixel against the z-buffer, which stores 1/w so that larger
+// values are closer to the camera. A passing pixel writes its depth.
+///////////////////////////////////////////////////////////////////////////////
+bool depth_test(int x, int y, float reciprocal_w) {
+    if (x < 0 || x >= window_width || y < 0 || y >= window_height) {
+        return false;
+    }
+    frame_stats.pixels_depth_tested++;
+    float* depth = &z_buffer[(window_width * y) + x];
+    if (reciprocal_w <= *depth) {
+        frame_stats.pixels_depth_rejected++;
+        return false;
+    }
+    *depth = reciprocal_w;
+    mark_depth_tile_dirty(x, y);
+    return true;
+}
+
+int depth_tile_count(void) {
+    return depth_tiles_per_row() * ((window_height + DEPTH_TILE_SIZE - 1) / DEPTH_TILE_SIZE);
+}
 
-    int longest_side_length = (abs(delta_x) >= abs(delta_y)) ? abs(delta_x) : abs(delta_y);
+///////////////////////////////////////////////////////////////////////////////
+// Check if the tile holding pixel x, y is entirely in front of a depth, using
+// the stored farthest depth even when dirty. Pixel writes only ever bring a
+// tile closer, so a stale value errs on the side of drawing.
+///////////////////////////////////////////////////////////////////////////////
+bool depth_tile_occluded(int x, int y, float nearest_reciprocal_w) {
+    if (x < 0 || x >= window_width || y < 0 || y >= window_height) {
+        return false;
+    }
+    depth_tile_t* tile = &depth_tiles[depth_tiles_per_row() * (y / DEPTH_TILE_SIZE) + (x / DEPTH_TILE_SIZE)];
+    return nearest_reciprocal_w <= tile->farthest;
+}
 
-    float x_inc = delta_x / (float)longest_side_length;
-    float y_inc = delta_y / (float)longest_side_length;
+///////////////////////////////////////////////////////////////////////////////
+// Check if every tile overlapping the pixel rectangle is entirely in front of
+// a depth, refreshing the farthest depth of dirty tiles as they are visited
+///////////////////////////////////////////////////////////////////////////////
+bool depth_region_occluded(int x_min, int y_min, int x_max, int y_max, float nearest_reciprocal_w) {
+    if (x_min < 0) x_min = 0;
+    if (y_min < 0) y_min = 0;
+    if (x_max >= window_width) x_max = window_width - 1;
+    if (y_max >= window_height) y_max = window_height - 1;
+    if (x_min > x_max || y_min > y_max) {
+        return true;
+    }
 
-    float current_x = x0;
-    float current_y = y0;
+    int tiles_per_row = depth_tiles_per_row();
+    for (int tile_y = y_min / DEPTH_TILE_SIZE; tile_y <= y_max / DEPTH_TILE_SIZE; tile_y++) {
+        for (int tile_x = x_min / DEPTH_TILE_SIZE; tile_x <= x_max / DEPTH_TILE_SIZE; tile_x++) {
+            depth_tile_t* tile = &depth_tiles[tiles_per_row * tile_y + tile_x];
+            if (tile->dirty) {
+                refresh_depth_tile(tile, tile_x, tile_y);
+            }
+            if (nearest_reciprocal_w > tile->farthest) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
 
-    for (int i = 0; i <= longest_side_length; i++) {
-        draw_pixel(round(current_x), round(current_y), color);
-        current_x += x_inc;
-        current_y += y_inc;
+///////////////////////////////////////////////////////////////////////////////
+// Switch the frame pacing, turning the renderer's vsync on or off to match
+///////////////////////////////////////////////////////////////////////////////
+void set_frame_pacing(enum frame_pacing pacing) {
+    frame_pacing = pacing;
+    frame_deadline = 0;
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    if (SDL_RenderSetVSync(renderer, pacing == PACING_VSYNC) != 0) {
+        printf("Error setting vsync: %s\n", SDL_GetError());
     }
+#else
+    if (pacing == PACING_VSYNC) {
+        printf("Switching vsync needs SDL 2.0.18 or later.\n");
+    }
+#endif
 }
 
-void draw_rect(int x, int y, int width, int height, uint32_t color) {
-    for (int i = 0; i < width; i++) {
-        for (int j = 0; j < height; j++) {
-            int current_x = x + i;
-            int current_y = y + j;
-            draw_pixel(current_x, current_y, color);
+///////////////////////////////////////////////////////////////////////////////
+// With PACING_TARGET_RATE, wait until the next frame is due. Deadlines follow
+// each other by the frame period, so the rate doesn't drift with the sleeps
+// overshooting, and restart from now after a frame that ran late. Sleeps in
+// whole milliseconds and only spins for the last one, which SDL_Delay may
+// overshoot.
+///////////////////////////////////////////////////////////////////////////////
+void wait_for_next_frame(void) {
+    if (frame_pacing != PACING_TARGET_RATE || target_frame_rate <= 0) {
+        return;
+    }
+    Uint64 frequency = SDL_GetPerformanceFrequency();
+    Uint64 now = SDL_GetPerformanceCounter();
+    frame_deadline += frequency / target_frame_rate;
+    if (frame_deadline < now) {
+        frame_deadline = now;
+        return;
+    }
+    for (;;) {
+        Uint64 ms_left = (frame_deadline - now) * 1000 / frequency;
+        if (ms_left > 1) {
+            SDL_Delay((Uint32)(ms_left - 1));
+        }
+        now = SDL_GetPerformanceCounter();
+        if (now >= frame_deadline) {
+            return;
         }
     }
 }
@@ -97,14 +323,41 @@ void render_color_buffer(void) {
     SDL_RenderCopy(renderer, color_buffer_texture, NULL, NULL);
 }
 
-void clear_color_buffer(uint32_t color) {
-    for (int y = 0; y < window_height; y++) {
+// Rows cleared by each job of the buffer clears
+#define CLEAR_ROWS_PER_JOB 16
+
+static void clear_color_rows(void* data, int start, int end) {
+    uint32_t color = *(uint32_t*)data;
+    for (int y = start; y < end; y++) {
         for (int x = 0; x < window_width; x++) {
             color_buffer[(window_width * y) + x] = color;
         }
     }
 }
 
+static void clear_z_rows(void* data, int start, int end) {
+    (void)data;
+    // A 1/w of zero is infinitely far away, so every pixel passes the first test
+    for (int y = start; y < end; y++) {
+        for (int x = 0; x < window_width; x++) {
+            z_buffer[(window_width * y) + x] = 0.0;
+        }
+    }
+}
+
+void clear_color_buffer(uint32_t color) {
+    job_parallel_for(window_height, CLEAR_ROWS_PER_JOB, clear_color_rows, &color);
+}
+
+void clear_z_buffer(void) {
+    job_parallel_for(window_height, CLEAR_ROWS_PER_JOB, clear_z_rows, NULL);
+    int num_tiles = depth_tile_count();
+    for (int i = 0; i < num_tiles; i++) {
+        depth_tiles[i].farthest = 0.0;
+        depth_tiles[i].dirty = false;
+    }
+}
+
 void destroy_window(void) {
     SDL_DestroyRenderer(renderer);
     SDL_DestroyWindow(window);
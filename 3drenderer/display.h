@@ -5,8 +5,7 @@
 #include <stdbool.h>
 #include <SDL2/SDL.h>
 
-#define FPS 90
-#define FRAME_TARGET_TIME (1000 / FPS)
+#define DEPTH_TILE_SIZE 8
 
 enum cull_method {
     CULL_NONE,
@@ -19,23 +18,77 @@ enum render_method {
     RENDER_FILL_TRIANGLE,
     RENDER_FILL_TRIANGLE_WIRE,
     RENDER_TEXTURED,
-    RENDER_TEXTURED_WIRE
+    RENDER_TEXTURED_WIRE,
+    RENDER_TEXTURED_AFFINE
 } render_method;
 
+enum raster_method {
+    RASTER_SCANLINE,
+    RASTER_EDGE
+} raster_method;
+
+enum texel_interpolation {
+    INTERPOLATE_BARYCENTRIC,
+    INTERPOLATE_INCREMENTAL
+} texel_interpolation;
+
+enum depth_method {
+    DEPTH_SORT,
+    DEPTH_BUFFER
+} depth_method;
+
+// How the frames are paced: on the display's refresh (the default), as fast
+// as possible, or at target_frame_rate
+enum frame_pacing {
+    PACING_VSYNC,
+    PACING_UNCAPPED,
+    PACING_TARGET_RATE
+} frame_pacing;
+
+////////////////////////////////////////////////////////////////////////////////
+// Coarse depth for a tile of DEPTH_TILE_SIZE x DEPTH_TILE_SIZE pixels. farthest
+// is the smallest 1/w in the tile, or lower while the tile is dirty.
+////////////////////////////////////////////////////////////////////////////////
+typedef struct {
+    float farthest;
+    bool dirty;
+} depth_tile_t;
+
+////////////////////////////////////////////////////////////////////////////////
+// Inclusive rectangle of pixels that a draw call is allowed to write
+////////////////////////////////////////////////////////////////////////////////
+typedef struct {
+    int x_min, y_min;
+    int x_max, y_max;
+} rect_t;
+
 extern SDL_Window* window;
 extern SDL_Renderer* renderer;
 extern uint32_t* color_buffer;
+extern float* z_buffer;
+extern depth_tile_t* depth_tiles;
+extern bool use_depth_tiles;
 extern SDL_Texture* color_buffer_texture;
 extern int window_width;
 extern int window_height;
+extern int target_frame_rate;
 
 bool initialize_window(void);
+rect_t window_rect(void);
 void draw_grid(void);
 void draw_pixel(int x, int y, uint32_t color);
-void draw_line(int x0, int y0, int x1, int y1, uint32_t color);
-void draw_rect(int x, int y, int width, int height, uint32_t color);
+void draw_line(int x0, int y0, int x1, int y1, uint32_t color, rect_t clip);
+void draw_rect(int x, int y, int width, int height, uint32_t color, rect_t clip);
+bool depth_test(int x, int y, float reciprocal_w);
+void mark_depth_tile_dirty(int x, int y);
+int depth_tile_count(void);
+bool depth_tile_occluded(int x, int y, float nearest_reciprocal_w);
+bool depth_region_occluded(int x_min, int y_min, int x_max, int y_max, float nearest_reciprocal_w);
+void set_frame_pacing(enum frame_pacing pacing);
+void wait_for_next_frame(void);
 void render_color_buffer(void);
 void clear_color_buffer(uint32_t color);
+void clear_z_buffer(void);
 void destroy_window(void);
 
 #endif
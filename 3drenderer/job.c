@@ -0,0 +1,343 @@
+// Needed by pthread_setaffinity_np, before any header pulls in the system ones
+#if defined(__linux__)
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <sched.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "job.h"
+
+int job_threads = 1;
+
+///////////////////////////////////////////////////////////////////////////////
+// Chase-Lev work stealing deque. The owning thread pushes and pops jobs at
+// the bottom, while other threads steal the oldest jobs from the top. Only a
+// pop racing thieves for the last job needs a compare and swap. The SDL
+// atomic operations are full barriers, which orders the owner's store of
+// bottom against its load of top, and the thieves' loads the other way.
+//
+// The indices only ever grow and wrap around after 2^32 jobs, so they are
+// stepped as unsigned and compared by their difference, which stays small.
+///////////////////////////////////////////////////////////////////////////////
+typedef struct {
+    void* jobs[JOB_DEQUE_SIZE];
+    SDL_atomic_t top;    // next job to steal, only ever moves up
+    SDL_atomic_t bottom; // next free slot, only moved by the owner
+} job_deque_t;
+
+static unsigned int deque_index(SDL_atomic_t* index) {
+    return (unsigned int)SDL_AtomicGet(index);
+}
+
+// Jobs between top and bottom, negative while a pop has moved bottom below top
+static int deque_size(unsigned int top, unsigned int bottom) {
+    return (int)(bottom - top);
+}
+
+static bool deque_push(job_deque_t* deque, job_t* job) {
+    unsigned int bottom = deque_index(&deque->bottom);
+    if (deque_size(deque_index(&deque->top), bottom) >= JOB_DEQUE_SIZE) {
+        return false;
+    }
+    SDL_AtomicSetPtr(&deque->jobs[bottom & (JOB_DEQUE_SIZE - 1)], job);
+    SDL_AtomicSet(&deque->bottom, (int)(bottom + 1));
+    return true;
+}
+
+static job_t* deque_pop(job_deque_t* deque) {
+    unsigned int bottom = (unsigned int)SDL_AtomicAdd(&deque->bottom, -1) - 1;
+    unsigned int top = deque_index(&deque->top);
+    if (deque_size(top, bottom) < 0) {
+        SDL_AtomicSet(&deque->bottom, (int)(bottom + 1));
+        return NULL;
+    }
+    job_t* job = (job_t*)SDL_AtomicGetPtr(&deque->jobs[bottom & (JOB_DEQUE_SIZE - 1)]);
+    if (top == bottom) {
+        // The last job, which a thief may be taking at the same time
+        if (!SDL_AtomicCAS(&deque->top, (int)top, (int)(top + 1))) {
+            job = NULL;
+        }
+        SDL_AtomicSet(&deque->bottom, (int)(bottom + 1));
+    }
+    return job;
+}
+
+static job_t* deque_steal(job_deque_t* deque) {
+    unsigned int top = deque_index(&deque->top);
+    unsigned int bottom = deque_index(&deque->bottom);
+    if (deque_size(top, bottom) <= 0) {
+        return NULL;
+    }
+    // The slot may be reused once another thief moves top, but then the swap fails
+    job_t* job = (job_t*)SDL_AtomicGetPtr(&deque->jobs[top & (JOB_DEQUE_SIZE - 1)]);
+    if (!SDL_AtomicCAS(&deque->top, (int)top, (int)(top + 1))) {
+        return NULL;
+    }
+    return job;
+}
+
+static bool deque_empty(job_deque_t* deque) {
+    return deque_size(deque_index(&deque->top), deque_index(&deque->bottom)) <= 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Thread of the pool. Thread 0 is the main thread, which runs jobs while it
+// waits on counters, and the others are workers running jobs until freed.
+// Each keeps a pointer to its own frame_stats so the main thread can merge
+// them between frames.
+///////////////////////////////////////////////////////////////////////////////
+typedef struct {
+    job_deque_t deque;
+    SDL_Thread* thread;
+    frame_stats_t* stats;
+    int index;
+} job_worker_t;
+
+static job_worker_t* workers = NULL;
+static THREAD_LOCAL int worker_index = 0;
+static bool pin_workers = false;
+
+// Threads with nothing to do sleep on wake, and are woken when jobs are
+// submitted or a counter they wait on reaches zero
+static SDL_mutex* sleep_lock = NULL;
+static SDL_cond* wake = NULL;
+static SDL_atomic_t sleepers;
+static SDL_atomic_t workers_ready;
+static SDL_atomic_t workers_quit;
+
+// Times to look for a job before going to sleep
+#define JOB_SPIN_COUNT 64
+
+static void pin_thread(int cpu) {
+    cpu %= SDL_GetCPUCount();
+#if defined(__linux__)
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu, &cpus);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) != 0) {
+        printf("Error pinning job thread %d to CPU %d.\n", worker_index, cpu);
+    }
+#elif defined(_WIN32)
+    if (SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << cpu) == 0) {
+        printf("Error pinning job thread %d to CPU %d.\n", worker_index, cpu);
+    }
+#else
+    (void)cpu;
+    printf("Pinning job threads is not supported on this platform.\n");
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Next job for the calling thread: the newest of its own, or else the oldest
+// of another thread, visiting them in turn from the next one
+///////////////////////////////////////////////////////////////////////////////
+static job_t* find_job(void) {
+    job_t* job = deque_pop(&workers[worker_index].deque);
+    for (int i = 1; job == NULL && i < job_threads; i++) {
+        job = deque_steal(&workers[(worker_index + i) % job_threads].deque);
+    }
+    return job;
+}
+
+static bool any_jobs(void) {
+    for (int i = 0; i < job_threads; i++) {
+        if (!deque_empty(&workers[i].deque)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void run_job(job_t* job) {
+    job_counter_t* counter = job->counter;
+    job->function(job->data, job->start, job->end);
+    if (SDL_AtomicAdd(&counter->pending, -1) == 1 && SDL_AtomicGet(&sleepers) > 0) {
+        // Wake a thread waiting on the counter
+        SDL_LockMutex(sleep_lock);
+        SDL_CondBroadcast(wake);
+        SDL_UnlockMutex(sleep_lock);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Sleep until woken, unless a job shows up or done (when given) is reached
+// while the thread announces it is going to sleep
+///////////////////////////////////////////////////////////////////////////////
+static void sleep_until_work(job_counter_t* done) {
+    SDL_LockMutex(sleep_lock);
+    SDL_AtomicAdd(&sleepers, 1);
+    if (!SDL_AtomicGet(&workers_quit) && !any_jobs() && (done == NULL || SDL_AtomicGet(&done->pending) > 0)) {
+        SDL_CondWait(wake, sleep_lock);
+    }
+    SDL_AtomicAdd(&sleepers, -1);
+    SDL_UnlockMutex(sleep_lock);
+}
+
+static int worker_main(void* data) {
+    job_worker_t* worker = (job_worker_t*)data;
+    worker_index = worker->index;
+    worker->stats = &frame_stats;
+    if (pin_workers) {
+        pin_thread(worker->index);
+    }
+    SDL_AtomicAdd(&workers_ready, 1);
+
+    int idle = 0;
+    while (!SDL_AtomicGet(&workers_quit)) {
+        job_t* job = find_job();
+        if (job != NULL) {
+            run_job(job);
+            idle = 0;
+        } else if (++idle >= JOB_SPIN_COUNT) {
+            sleep_until_work(NULL);
+            idle = 0;
+        }
+    }
+    return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Start num_threads - 1 workers next to the main thread, pinning each thread
+// to its own CPU (wrapping around when there are more threads) when
+// pin_threads is set
+///////////////////////////////////////////////////////////////////////////////
+void job_system_init(int num_threads, bool pin_threads) {
+    job_threads = num_threads > 1 ? num_threads : 1;
+    pin_workers = pin_threads;
+    sleep_lock = SDL_CreateMutex();
+    wake = SDL_CreateCond();
+    SDL_AtomicSet(&sleepers, 0);
+    SDL_AtomicSet(&workers_ready, 0);
+    SDL_AtomicSet(&workers_quit, 0);
+
+    workers = (job_worker_t*)calloc(job_threads, sizeof(job_worker_t));
+    workers[0].stats = &frame_stats;
+    if (pin_workers) {
+        pin_thread(0);
+    }
+    for (int i = 1; i < job_threads; i++) {
+        workers[i].index = i;
+        workers[i].thread = SDL_CreateThread(worker_main, "job", &workers[i]);
+        if (workers[i].thread == NULL) {
+            printf("Error creating job thread: %s\n", SDL_GetError());
+            job_threads = i;
+            break;
+        }
+    }
+
+    // Wait for the workers to publish their stats before any frame ends
+    while (SDL_AtomicGet(&workers_ready) < job_threads - 1) {
+        SDL_Delay(1);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Index of the calling thread in the pool, from 0 for the main thread to
+// job_threads - 1, for jobs keeping data per thread
+///////////////////////////////////////////////////////////////////////////////
+int job_thread_index(void) {
+    return worker_index;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Queue count jobs on the calling thread, which must be the main thread or
+// run inside a job. Jobs that do not fit in its deque are run right away.
+// The jobs must stay in memory until the counter is waited on.
+///////////////////////////////////////////////////////////////////////////////
+void job_submit(job_t* jobs, int count, job_counter_t* counter) {
+    SDL_AtomicAdd(&counter->pending, count);
+    int pushed = 0;
+    for (int i = 0; i < count; i++) {
+        jobs[i].counter = counter;
+        if (deque_push(&workers[worker_index].deque, &jobs[i])) {
+            pushed++;
+        } else {
+            run_job(&jobs[i]);
+        }
+    }
+    if (pushed > 0 && SDL_AtomicGet(&sleepers) > 0) {
+        SDL_LockMutex(sleep_lock);
+        SDL_CondBroadcast(wake);
+        SDL_UnlockMutex(sleep_lock);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Wait until every job submitted against the counter is done, running jobs
+// from any thread in the meantime
+///////////////////////////////////////////////////////////////////////////////
+void job_wait(job_counter_t* counter) {
+    int idle = 0;
+    while (SDL_AtomicGet(&counter->pending) > 0) {
+        job_t* job = find_job();
+        if (job != NULL) {
+            run_job(job);
+            idle = 0;
+        } else if (++idle >= JOB_SPIN_COUNT) {
+            sleep_until_work(counter);
+            idle = 0;
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Run function over [0, count) split into jobs of at least grain indices,
+// returning once all of them are done
+///////////////////////////////////////////////////////////////////////////////
+void job_parallel_for(int count, int grain, job_function_t function, void* data) {
+    if (job_threads == 1 || count <= grain) {
+        if (count > 0) {
+            function(data, 0, count);
+        }
+        return;
+    }
+    int min_grain = (count + JOB_PARALLEL_FOR_MAX_JOBS - 1) / JOB_PARALLEL_FOR_MAX_JOBS;
+    if (grain < min_grain) {
+        grain = min_grain;
+    }
+
+    job_t jobs[JOB_PARALLEL_FOR_MAX_JOBS];
+    int num_jobs = 0;
+    for (int start = 0; start < count; start += grain) {
+        jobs[num_jobs].function = function;
+        jobs[num_jobs].data = data;
+        jobs[num_jobs].start = start;
+        jobs[num_jobs].end = (start + grain < count) ? start + grain : count;
+        num_jobs++;
+    }
+    job_counter_t counter;
+    SDL_AtomicSet(&counter.pending, 0);
+    job_submit(jobs, num_jobs, &counter);
+    job_wait(&counter);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Add the counters of the worker threads to stats and reset them. Only
+// called by the main thread while no jobs are running.
+///////////////////////////////////////////////////////////////////////////////
+void job_system_merge_stats(frame_stats_t* stats) {
+    for (int i = 1; i < job_threads; i++) {
+        stats_merge(stats, workers[i].stats);
+        memset(workers[i].stats, 0, sizeof(frame_stats_t));
+    }
+}
+
+void job_system_free(void) {
+    SDL_LockMutex(sleep_lock);
+    SDL_AtomicSet(&workers_quit, 1);
+    SDL_CondBroadcast(wake);
+    SDL_UnlockMutex(sleep_lock);
+    for (int i = 1; i < job_threads; i++) {
+        SDL_WaitThread(workers[i].thread, NULL);
+    }
+    SDL_DestroyCond(wake);
+    SDL_DestroyMutex(sleep_lock);
+    free(workers);
+    workers = NULL;
+    job_threads = 1;
+}
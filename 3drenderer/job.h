@@ -0,0 +1,43 @@
+#ifndef JOB_H
+#define JOB_H
+
+#include <stdbool.h>
+#include <SDL2/SDL.h>
+#include "stats.h"
+
+// Jobs each thread can hold in its deque before submitting runs them inline
+#define JOB_DEQUE_SIZE 1024
+
+// Most jobs a parallel for splits its range into
+#define JOB_PARALLEL_FOR_MAX_JOBS 256
+
+////////////////////////////////////////////////////////////////////////////////
+// A job runs function over the index range [start, end) of data. Jobs count
+// down their counter when done, so waiting on a counter waits for every job
+// submitted against it, and a job can wait on the counters of the jobs it
+// depends on.
+////////////////////////////////////////////////////////////////////////////////
+typedef void (*job_function_t)(void* data, int start, int end);
+
+typedef struct {
+    SDL_atomic_t pending; // jobs submitted against the counter and not finished
+} job_counter_t;
+
+typedef struct {
+    job_function_t function;
+    void* data;
+    int start, end;
+    job_counter_t* counter;
+} job_t;
+
+extern int job_threads;
+
+void job_system_init(int num_threads, bool pin_threads);
+int job_thread_index(void);
+void job_submit(job_t* jobs, int count, job_counter_t* counter);
+void job_wait(job_counter_t* counter);
+void job_parallel_for(int count, int grain, job_function_t function, void* data);
+void job_system_merge_stats(frame_stats_t* stats);
+void job_system_free(void);
+
+#endif
@@ -117,15 +117,95 @@ mat4_t mat4_make_perspective(float fov, float aspect, float znear, float zfar) {
     return m;
 }
 
-vec4_t mat4_mul_vec4_project(mat4_t mat_proj, vec4_t v) {
-    // multiply the projection matrix by our original vector
-    vec4_t result = mat4_mul_vec4(mat_proj, v);
-
-    // perform perspective divide with original z-value that is now stored in w
-    if (result.w != 0.0) {
-        result.x /= result.w;
-        result.y /= result.w;
-        result.z /= result.w;
+float mat4_max_scale(mat4_t m) {
+    // The scale along each axis is the length of the matching column of the upper 3x3
+    float max_scale = 0;
+    for (int j = 0; j < 3; j++) {
+        float scale = sqrt(m.m[0][j] * m.m[0][j] + m.m[1][j] * m.m[1][j] + m.m[2][j] * m.m[2][j]);
+        if (scale > max_scale) {
+            max_scale = scale;
+        }
+    }
+    return max_scale;
+}
+
+mat4_t mat4_transpose(mat4_t m) {
+    mat4_t t;
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 4; j++) {
+            t.m[i][j] = m.m[j][i];
+        }
+    }
+    return t;
+}
+
+mat4_t mat4_inverse(mat4_t m) {
+    // Inverse by cofactor expansion, pairing up the 2x2 minors of the top and bottom row pairs
+    float s0 = m.m[0][0] * m.m[1][1] - m.m[1][0] * m.m[0][1];
+    float s1 = m.m[0][0] * m.m[1][2] - m.m[1][0] * m.m[0][2];
+    float s2 = m.m[0][0] * m.m[1][3] - m.m[1][0] * m.m[0][3];
+    float s3 = m.m[0][1] * m.m[1][2] - m.m[1][1] * m.m[0][2];
+    float s4 = m.m[0][1] * m.m[1][3] - m.m[1][1] * m.m[0][3];
+    float s5 = m.m[0][2] * m.m[1][3] - m.m[1][2] * m.m[0][3];
+    float c5 = m.m[2][2] * m.m[3][3] - m.m[3][2] * m.m[2][3];
+    float c4 = m.m[2][1] * m.m[3][3] - m.m[3][1] * m.m[2][3];
+    float c3 = m.m[2][1] * m.m[3][2] - m.m[3][1] * m.m[2][2];
+    float c2 = m.m[2][0] * m.m[3][3] - m.m[3][0] * m.m[2][3];
+    float c1 = m.m[2][0] * m.m[3][2] - m.m[3][0] * m.m[2][2];
+    float c0 = m.m[2][0] * m.m[3][1] - m.m[3][0] * m.m[2][1];
+
+    float det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+    if (det == 0) {
+        return mat4_identity();
     }
+    float inv_det = 1.0 / det;
+
+    mat4_t r;
+    r.m[0][0] = ( m.m[1][1] * c5 - m.m[1][2] * c4 + m.m[1][3] * c3) * inv_det;
+    r.m[0][1] = (-m.m[0][1] * c5 + m.m[0][2] * c4 - m.m[0][3] * c3) * inv_det;
+    r.m[0][2] = ( m.m[3][1] * s5 - m.m[3][2] * s4 + m.m[3][3] * s3) * inv_det;
+    r.m[0][3] = (-m.m[2][1] * s5 + m.m[2][2] * s4 - m.m[2][3] * s3) * inv_det;
+    r.m[1][0] = (-m.m[1][0] * c5 + m.m[1][2] * c2 - m.m[1][3] * c1) * inv_det;
+    r.m[1][1] = ( m.m[0][0] * c5 - m.m[0][2] * c2 + m.m[0][3] * c1) * inv_det;
+    r.m[1][2] = (-m.m[3][0] * s5 + m.m[3][2] * s2 - m.m[3][3] * s1) * inv_det;
+    r.m[1][3] = ( m.m[2][0] * s5 - m.m[2][2] * s2 + m.m[2][3] * s1) * inv_det;
+    r.m[2][0] = ( m.m[1][0] * c4 - m.m[1][1] * c2 + m.m[1][3] * c0) * inv_det;
+    r.m[2][1] = (-m.m[0][0] * c4 + m.m[0][1] * c2 - m.m[0][3] * c0) * inv_det;
+    r.m[2][2] = ( m.m[3][0] * s4 - m.m[3][1] * s2 + m.m[3][3] * s0) * inv_det;
+    r.m[2][3] = (-m.m[2][0] * s4 + m.m[2][1] * s2 - m.m[2][3] * s0) * inv_det;
+    r.m[3][0] = (-m.m[1][0] * c3 + m.m[1][1] * c1 - m.m[1][2] * c0) * inv_det;
+    r.m[3][1] = ( m.m[0][0] * c3 - m.m[0][1] * c1 + m.m[0][2] * c0) * inv_det;
+    r.m[3][2] = (-m.m[3][0] * s3 + m.m[3][1] * s1 - m.m[3][2] * s0) * inv_det;
+    r.m[3][3] = ( m.m[2][0] * s3 - m.m[2][1] * s1 + m.m[2][2] * s0) * inv_det;
+    return r;
+}
+
+vec3_t mat4_mul_direction(mat4_t m, vec3_t v) {
+    // Multiply by the upper 3x3 only, so translation does not apply to directions and normals
+    vec3_t result;
+    result.x = m.m[0][0] * v.x + m.m[0][1] * v.y + m.m[0][2] * v.z;
+    result.y = m.m[1][0] * v.x + m.m[1][1] * v.y + m.m[1][2] * v.z;
+    result.z = m.m[2][0] * v.x + m.m[2][1] * v.y + m.m[2][2] * v.z;
     return result;
 }
+
+mat4_t mat4_look_at(vec3_t eye, vec3_t target, vec3_t up) {
+    // Build the camera basis: z looks at the target, x points right, y points up
+    vec3_t z = vec3_sub(target, eye);
+    vec3_normalize(&z);
+    vec3_t x = vec3_cross(up, z);
+    vec3_normalize(&x);
+    vec3_t y = vec3_cross(z, x);
+
+    // | x.x   x.y   x.z  -dot(x,eye) |
+    // | y.x   y.y   y.z  -dot(y,eye) |
+    // | z.x   z.y   z.z  -dot(z,eye) |
+    // |   0     0     0            1 |
+    mat4_t view_matrix = {{
+        { x.x, x.y, x.z, -vec3_dot(x, eye) },
+        { y.x, y.y, y.z, -vec3_dot(y, eye) },
+        { z.x, z.y, z.z, -vec3_dot(z, eye) },
+        {   0,   0,   0,                 1 }
+    }};
+    return view_matrix;
+}
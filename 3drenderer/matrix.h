@@ -16,6 +16,10 @@ mat4_t mat4_make_rotation_z(float angle);
 mat4_t mat4_make_perspective(float fov, float aspect, float znear, float zfar);
 vec4_t mat4_mul_vec4(mat4_t m, vec4_t v);
 mat4_t mat4_mul_mat4(mat4_t a, mat4_t b);
-vec4_t mat4_mul_vec4_project(mat4_t mat_proj, vec4_t v);
+float mat4_max_scale(mat4_t m);
+mat4_t mat4_transpose(mat4_t m);
+mat4_t mat4_inverse(mat4_t m);
+vec3_t mat4_mul_direction(mat4_t m, vec3_t v);
+mat4_t mat4_look_at(vec3_t eye, vec3_t target, vec3_t up);
 
 #endif
@@ -1,16 +1,9 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include "array.h"
 #include "mesh.h"
 
-mesh_t mesh = {
-    .vertices = NULL,
-    .faces = NULL,
-    .rotation = { 0, 0, 0 },
-    .scale = { 1.0, 1.0, 1.0 },
-    .translation = { 0, 0, 0 }
-};
-
 vec3_t cube_vertices[N_CUBE_VERTICES] = {
     { .x = -1, .y = -1, .z = -1 }, // 1
     { .x = -1, .y =  1, .z = -1 }, // 2
@@ -43,20 +36,28 @@ face_t cube_faces[N_CUBE_FACES] = {
     { .a = 6, .b = 1, .c = 4, .a_uv = { 0, 1 }, .b_uv = { 1, 0 }, .c_uv = { 1, 1 }, .color = 0xFFFFFFFF }
 };
 
-void load_cube_mesh_data(void) {
+void load_cube_mesh_data(mesh_t* mesh) {
     for (int i = 0; i < N_CUBE_VERTICES; i++) {
         vec3_t cube_vertex = cube_vertices[i];
-        array_push(mesh.vertices, cube_vertex);
+        array_push(mesh->vertices, cube_vertex);
     }
     for (int i = 0; i < N_CUBE_FACES; i++) {
         face_t cube_face = cube_faces[i];
-        array_push(mesh.faces, cube_face);
+        array_push(mesh->faces, cube_face);
     }
+    vertex_streams_init(&mesh->vertex_streams, mesh->vertices, array_length(mesh->vertices));
+    compute_face_normals(mesh);
+    compute_mesh_bounds(mesh);
+    compute_mesh_edges(mesh);
 }
 
-void load_obj_file_data(char* filename) {
+void load_obj_file_data(mesh_t* mesh, char* filename) {
     FILE* file;
     file = fopen(filename, "r");
+    if (file == NULL) {
+        printf("Error opening mesh file %s.\n", filename);
+        return;
+    }
     char line[1024];
 
     while (fgets(line, 1024, file)) {
@@ -64,7 +65,7 @@ void load_obj_file_data(char* filename) {
         if (strncmp(line, "v ", 2) == 0) {
             vec3_t vertex;
             sscanf(line, "v %f %f %f", &vertex.x, &vertex.y, &vertex.z);
-            array_push(mesh.vertices, vertex);
+            array_push(mesh->vertices, vertex);
         }
         // Face information
         if (strncmp(line, "f ", 2) == 0) {
@@ -83,7 +84,127 @@ void load_obj_file_data(char* filename) {
                 .c = vertex_indices[2],
                 .color = 0xFFFFFFFF
             };
-            array_push(mesh.faces, face);
+            array_push(mesh->faces, face);
+        }
+    }
+    fclose(file);
+
+    vertex_streams_init(&mesh->vertex_streams, mesh->vertices, array_length(mesh->vertices));
+    compute_face_normals(mesh);
+    compute_mesh_bounds(mesh);
+    compute_mesh_edges(mesh);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Compute the unit normal of every face once in object space, using the same
+// clockwise winding (A, B, C) the backface culling test expects
+///////////////////////////////////////////////////////////////////////////////
+void compute_face_normals(mesh_t* mesh) {
+    int num_faces = array_length(mesh->faces);
+    for (int i = 0; i < num_faces; i++) {
+        face_t face = mesh->faces[i];
+        vec3_t vector_a = mesh->vertices[face.a - 1];
+        vec3_t vector_b = mesh->vertices[face.b - 1];
+        vec3_t vector_c = mesh->vertices[face.c - 1];
+
+        vec3_t normal = vec3_cross(vec3_sub(vector_b, vector_a), vec3_sub(vector_c, vector_a));
+        vec3_normalize(&normal);
+        array_push(mesh->face_normals, normal);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Compute the bounding box of the vertices, and a bounding sphere centered on
+// the box that reaches the farthest vertex
+///////////////////////////////////////////////////////////////////////////////
+void compute_mesh_bounds(mesh_t* mesh) {
+    int num_vertices = array_length(mesh->vertices);
+    if (num_vertices == 0) {
+        mesh->aabb_min = mesh->aabb_max = mesh->bounding_center = (vec3_t){ 0, 0, 0 };
+        mesh->bounding_radius = 0;
+        return;
+    }
+
+    vec3_t min = mesh->vertices[0];
+    vec3_t max = mesh->vertices[0];
+    for (int i = 1; i < num_vertices; i++) {
+        vec3_t v = mesh->vertices[i];
+        if (v.x < min.x) min.x = v.x;
+        if (v.y < min.y) min.y = v.y;
+        if (v.z < min.z) min.z = v.z;
+        if (v.x > max.x) max.x = v.x;
+        if (v.y > max.y) max.y = v.y;
+        if (v.z > max.z) max.z = v.z;
+    }
+
+    vec3_t center = vec3_mul(vec3_add(min, max), 0.5);
+    float radius = 0;
+    for (int i = 0; i < num_vertices; i++) {
+        float distance = vec3_length(vec3_sub(mesh->vertices[i], center));
+        if (distance > radius) {
+            radius = distance;
         }
     }
+
+    mesh->aabb_min = min;
+    mesh->aabb_max = max;
+    mesh->bounding_center = center;
+    mesh->bounding_radius = radius;
+}
+
+typedef struct {
+    uint64_t key;  // lower vertex index in the high bits, higher vertex index in the low bits
+    int face_edge; // slot in face_edges: face index * 3 + edge of the face
+} face_edge_key_t;
+
+static int compare_face_edge_keys(const void* a, const void* b) {
+    uint64_t key_a = ((const face_edge_key_t*)a)->key;
+    uint64_t key_b = ((const face_edge_key_t*)b)->key;
+    return (key_a > key_b) - (key_a < key_b);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Build the list of unique edges by sorting the three edges of every face on
+// their vertex pair, so the faces sharing an edge end up next to each other
+// and point at the same entry of mesh->edges
+///////////////////////////////////////////////////////////////////////////////
+void compute_mesh_edges(mesh_t* mesh) {
+    int num_faces = array_length(mesh->faces);
+    if (num_faces == 0) {
+        return;
+    }
+
+    face_edge_key_t* keys = (face_edge_key_t*)malloc(sizeof(face_edge_key_t) * num_faces * 3);
+    for (int i = 0; i < num_faces; i++) {
+        int vertices[3] = { mesh->faces[i].a, mesh->faces[i].b, mesh->faces[i].c };
+        for (int j = 0; j < 3; j++) {
+            uint64_t a = vertices[j];
+            uint64_t b = vertices[(j + 1) % 3];
+            keys[i * 3 + j].key = (a < b) ? (a << 32) | b : (b << 32) | a;
+            keys[i * 3 + j].face_edge = i * 3 + j;
+        }
+        array_push(mesh->face_edges, 0);
+        array_push(mesh->face_edges, 0);
+        array_push(mesh->face_edges, 0);
+    }
+    qsort(keys, num_faces * 3, sizeof(face_edge_key_t), compare_face_edge_keys);
+
+    for (int i = 0; i < num_faces * 3; i++) {
+        if (i == 0 || keys[i].key != keys[i - 1].key) {
+            edge_t edge = { .a = (int)(keys[i].key >> 32), .b = (int)(keys[i].key & 0xFFFFFFFF) };
+            array_push(mesh->edges, edge);
+        }
+        mesh->face_edges[keys[i].face_edge] = array_length(mesh->edges) - 1;
+    }
+    free(keys);
+}
+
+void free_mesh_data(mesh_t* mesh) {
+    array_free(mesh->faces);
+    array_free(mesh->face_normals);
+    array_free(mesh->edges);
+    array_free(mesh->face_edges);
+    array_free(mesh->vertices);
+    vertex_streams_free(&mesh->vertex_streams);
+    free_texture(&mesh->texture);
 }
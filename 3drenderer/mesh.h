@@ -2,6 +2,8 @@
 #define MESH_H
 
 #include "vector.h"
+#include "texture.h"
+#include "transform.h"
 #include "triangle.h"
 
 #define N_CUBE_VERTICES 8
@@ -10,20 +12,36 @@
 extern vec3_t cube_vertices[N_CUBE_VERTICES];
 extern face_t cube_faces[N_CUBE_FACES];
 
+////////////////////////////////////////////////////////////////////////////////
+// Edge shared by the faces of a mesh, between two 1-based vertex indices
+////////////////////////////////////////////////////////////////////////////////
+typedef struct {
+    int a; // lower vertex index
+    int b; // higher vertex index
+} edge_t;
+
 ////////////////////////////////////////////////////////////////////////////////
 // Define a struct for dynamic size meshes, with array of vertices and faces
 ////////////////////////////////////////////////////////////////////////////////
 typedef struct {
     vec3_t* vertices;   // dynamic array of vertices
     face_t* faces;      // dynamic array of faces
-    vec3_t rotation;    // rotation with x, y, and z values
-    vec3_t scale;       // scale with x, y, and z values
-    vec3_t translation; // translation with x, y, and z values
+    vec3_t* face_normals; // dynamic array of object space unit normals, one per face
+    edge_t* edges;      // dynamic array of unique edges, each listed once however many faces share it
+    int* face_edges;    // dynamic array of three edge indices per face, for its edges AB, BC, and CA
+    vertex_streams_t vertex_streams; // aligned SoA copy of the vertices for batch transforms
+    vec3_t aabb_min;    // object space bounding box minimum corner
+    vec3_t aabb_max;    // object space bounding box maximum corner
+    vec3_t bounding_center; // object space bounding sphere center
+    float bounding_radius;  // object space bounding sphere radius
+    texture_t texture;  // texture shared by every instance of the mesh
 } mesh_t;
 
-extern mesh_t mesh;
-
-void load_cube_mesh_data(void);
-void load_obj_file_data(char* filename);
+void load_cube_mesh_data(mesh_t* mesh);
+void load_obj_file_data(mesh_t* mesh, char* filename);
+void compute_face_normals(mesh_t* mesh);
+void compute_mesh_bounds(mesh_t* mesh);
+void compute_mesh_edges(mesh_t* mesh);
+void free_mesh_data(mesh_t* mesh);
 
 #endif
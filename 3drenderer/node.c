@@ -0,0 +1,159 @@
+#include <stdlib.h>
+#include "array.h"
+#include "node.h"
+
+static bool vec3_equals(vec3_t a, vec3_t b) {
+    return a.x == b.x && a.y == b.y && a.z == b.z;
+}
+
+static bool node_is_moving(node_t* node) {
+    return !vec3_equals(node->previous_scale, node->scale) ||
+           !vec3_equals(node->previous_rotation, node->rotation) ||
+           !vec3_equals(node->previous_translation, node->translation);
+}
+
+node_t* node_create(mesh_t* mesh) {
+    node_t* node = (node_t*)malloc(sizeof(node_t));
+    node->mesh = mesh;
+    node->parent = NULL;
+    node->children = NULL;
+    node->scale = (vec3_t){ 1.0, 1.0, 1.0 };
+    node->rotation = (vec3_t){ 0, 0, 0 };
+    node->translation = (vec3_t){ 0, 0, 0 };
+    node->previous_scale = node->scale;
+    node->previous_rotation = node->rotation;
+    node->previous_translation = node->translation;
+    node->world_matrix = mat4_identity();
+    node->dirty = true;
+    return node;
+}
+
+void node_destroy(node_t* node) {
+    int num_children = array_length(node->children);
+    for (int i = 0; i < num_children; i++) {
+        node_destroy(node->children[i]);
+    }
+    array_free(node->children);
+    free(node);
+}
+
+void node_add_child(node_t* parent, node_t* child) {
+    child->parent = parent;
+    array_push(parent->children, child);
+    node_mark_dirty(child);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Setters only invalidate the cached world matrix when the value changes
+///////////////////////////////////////////////////////////////////////////////
+void node_set_scale(node_t* node, vec3_t scale) {
+    if (!vec3_equals(node->scale, scale)) {
+        node->scale = scale;
+        node_mark_dirty(node);
+    }
+}
+
+void node_set_rotation(node_t* node, vec3_t rotation) {
+    if (!vec3_equals(node->rotation, rotation)) {
+        node->rotation = rotation;
+        node_mark_dirty(node);
+    }
+}
+
+void node_set_translation(node_t* node, vec3_t translation) {
+    if (!vec3_equals(node->translation, translation)) {
+        node->translation = translation;
+        node_mark_dirty(node);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Flag a node and its whole subtree, since children inherit its world matrix
+///////////////////////////////////////////////////////////////////////////////
+void node_mark_dirty(node_t* node) {
+    if (node->dirty) {
+        return; // the subtree was already flagged
+    }
+    node->dirty = true;
+    int num_children = array_length(node->children);
+    for (int i = 0; i < num_children; i++) {
+        node_mark_dirty(node->children[i]);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Keep the current local transforms of the subtree as those of the previous
+// step, before the simulation advances them by one step. Nodes that moved in
+// the last step are flagged, since their world matrix may be interpolated.
+///////////////////////////////////////////////////////////////////////////////
+void node_save_previous_transforms(node_t* node) {
+    if (node_is_moving(node)) {
+        node->previous_scale = node->scale;
+        node->previous_rotation = node->rotation;
+        node->previous_translation = node->translation;
+        node_mark_dirty(node);
+    }
+    int num_children = array_length(node->children);
+    for (int i = 0; i < num_children; i++) {
+        node_save_previous_transforms(node->children[i]);
+    }
+}
+
+static vec3_t vec3_lerp(vec3_t a, vec3_t b, float alpha) {
+    vec3_t result = {
+        a.x + (b.x - a.x) * alpha,
+        a.y + (b.y - a.y) * alpha,
+        a.z + (b.z - a.z) * alpha
+    };
+    return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Local matrix at alpha between the previous step (0) and the current one
+// (1). The Euler angles are interpolated directly, which is fine for the
+// small changes of a single step.
+///////////////////////////////////////////////////////////////////////////////
+mat4_t node_local_matrix(node_t* node, float alpha) {
+    vec3_t scale = vec3_lerp(node->previous_scale, node->scale, alpha);
+    vec3_t rotation = vec3_lerp(node->previous_rotation, node->rotation, alpha);
+    vec3_t translation = vec3_lerp(node->previous_translation, node->translation, alpha);
+    mat4_t scale_matrix = mat4_make_scale(scale.x, scale.y, scale.z);
+    mat4_t translation_matrix = mat4_make_translation(translation.x, translation.y, translation.z);
+    mat4_t rotation_matrix_x = mat4_make_rotation_x(rotation.x);
+    mat4_t rotation_matrix_y = mat4_make_rotation_y(rotation.y);
+    mat4_t rotation_matrix_z = mat4_make_rotation_z(rotation.z);
+
+    // Order matters: First scale, then rotate, then translate. [T]*[R]*[S]*v
+    mat4_t local_matrix = scale_matrix;
+    local_matrix = mat4_mul_mat4(rotation_matrix_z, local_matrix);
+    local_matrix = mat4_mul_mat4(rotation_matrix_y, local_matrix);
+    local_matrix = mat4_mul_mat4(rotation_matrix_x, local_matrix);
+    local_matrix = mat4_mul_mat4(translation_matrix, local_matrix);
+    return local_matrix;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Walk the tree and recompute the world matrices at alpha between the
+// previous and current steps, only for dirty nodes and nodes moving in the
+// current step, along with everything below them
+///////////////////////////////////////////////////////////////////////////////
+static void update_world_matrix(node_t* node, float alpha, bool parent_changed) {
+    bool changed = node->dirty || parent_changed || node_is_moving(node);
+    if (changed) {
+        mat4_t local_matrix = node_local_matrix(node, alpha);
+        if (node->parent != NULL) {
+            node->world_matrix = mat4_mul_mat4(node->parent->world_matrix, local_matrix);
+        } else {
+            node->world_matrix = local_matrix;
+        }
+        node->dirty = false;
+    }
+    int num_children = array_length(node->children);
+    for (int i = 0; i < num_children; i++) {
+        update_world_matrix(node->children[i], alpha, changed);
+    }
+}
+
+void node_update_world_matrices(node_t* node, float alpha) {
+    update_world_matrix(node, alpha, false);
+}
@@ -0,0 +1,40 @@
+#ifndef NODE_H
+#define NODE_H
+
+#include <stdbool.h>
+#include "matrix.h"
+#include "mesh.h"
+#include "vector.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Define a struct for scene graph nodes, each with a local transform (scale,
+// rotation, and translation) relative to its parent and a cached world matrix.
+// The local transform of the previous simulation step is kept as well, so the
+// world matrix can be interpolated between the two steps.
+////////////////////////////////////////////////////////////////////////////////
+typedef struct node {
+    mesh_t* mesh;           // mesh drawn with this node's transform (NULL for pivots)
+    struct node* parent;    // parent node, or NULL for the root
+    struct node** children; // dynamic array of child nodes
+    vec3_t scale;           // scale with x, y, and z values
+    vec3_t rotation;        // rotation with x, y, and z values
+    vec3_t translation;     // translation with x, y, and z values
+    vec3_t previous_scale;       // scale at the previous simulation step
+    vec3_t previous_rotation;    // rotation at the previous simulation step
+    vec3_t previous_translation; // translation at the previous simulation step
+    mat4_t world_matrix;    // cached parent world matrix times local matrix
+    bool dirty;             // world matrix must be recomputed
+} node_t;
+
+node_t* node_create(mesh_t* mesh);
+void node_destroy(node_t* node);
+void node_add_child(node_t* parent, node_t* child);
+void node_set_scale(node_t* node, vec3_t scale);
+void node_set_rotation(node_t* node, vec3_t rotation);
+void node_set_translation(node_t* node, vec3_t translation);
+void node_mark_dirty(node_t* node);
+void node_save_previous_transforms(node_t* node);
+mat4_t node_local_matrix(node_t* node, float alpha);
+void node_update_world_matrices(node_t* node, float alpha);
+
+#endif
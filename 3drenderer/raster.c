@@ -0,0 +1,828 @@
+#include <math.h>
+#include <stdlib.h>
+#include "display.h"
+#include "raster.h"
+#include "stats.h"
+
+#if RASTER_SIMD_WIDTH == 8
+#include <immintrin.h>
+#elif RASTER_SIMD_WIDTH == 4
+#include <emmintrin.h>
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// Return how many pixels from x to the end of its depth tile (or of the span)
+// can be skipped because the tile is entirely in front of the triangle
+///////////////////////////////////////////////////////////////////////////////
+int occluded_tile_span(int x, int x_end, int y, float nearest_reciprocal_w) {
+    if (!depth_tile_occluded(x, y, nearest_reciprocal_w)) {
+        return 0;
+    }
+    int tile_end = x - (x % DEPTH_TILE_SIZE) + DEPTH_TILE_SIZE;
+    int skipped = (tile_end < x_end ? tile_end : x_end) - x;
+    frame_stats.pixels_tile_skipped += skipped;
+    return skipped;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Check the bounding box of a triangle against the depth tiles, so a triangle
+// behind everything drawn in the tiles it overlaps is skipped without setup.
+// The box grows by a pixel since the span ends are stepped in floats and
+// truncated, which can land one pixel outside the vertices.
+///////////////////////////////////////////////////////////////////////////////
+bool triangle_occluded(int x0, int y0, int x1, int y1, int x2, int y2, float nearest_reciprocal_w) {
+    int x_min = x0 < x1 ? (x0 < x2 ? x0 : x2) : (x1 < x2 ? x1 : x2);
+    int x_max = x0 > x1 ? (x0 > x2 ? x0 : x2) : (x1 > x2 ? x1 : x2);
+    int y_min = y0 < y1 ? (y0 < y2 ? y0 : y2) : (y1 < y2 ? y1 : y2);
+    int y_max = y0 > y1 ? (y0 > y2 ? y0 : y2) : (y1 > y2 ? y1 : y2);
+    if (depth_region_occluded(x_min - 1, y_min - 1, x_max + 1, y_max + 1, nearest_reciprocal_w)) {
+        frame_stats.triangles_occluded++;
+        return true;
+    }
+    return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Edge functions of a triangle over its screen bounding box. Each edge value
+// is twice the signed area of the subtriangle opposite a vertex, evaluated at
+// the pixel centers from vertices snapped to RASTER_SUBPIXEL_BITS of fixed
+// point. The values are exact integers and step by a constant from one pixel
+// to the next.
+//
+// The box is clamped to the window only, and the attributes are planes
+// anchored at its first pixel, so every pixel gets the same value whatever
+// part of the box is drawn. Drawing is limited to the first/last range, the
+// part of the box inside the clip rectangle of the call.
+///////////////////////////////////////////////////////////////////////////////
+/*
+            v0
+            /\
+     e1    /  \    e2
+          /    \
+         /  p   \
+       v2--------v1
+            e0
+*/
+typedef struct {
+    int x_min, y_min;
+    int x_max, y_max;
+    int x_first, y_first; // part of the box inside the clip rectangle
+    int x_last, y_last;
+    int e_row[3]; // edge values at (x_min, y) for the current row, from y_first down
+    int e_dx[3];  // edge steps for one pixel to the right
+    int e_dy[3];  // edge steps for one row down
+    float vertex_x[3], vertex_y[3]; // snapped vertex positions
+    float inv_area;
+} edge_setup_t;
+
+#define RASTER_SUBPIXEL_SCALE (1 << RASTER_SUBPIXEL_BITS)
+
+static int64_t edge_function(int64_t ax, int64_t ay, int64_t bx, int64_t by, int64_t px, int64_t py) {
+    return (bx - ax) * (py - ay) - (by - ay) * (px - ax);
+}
+
+static int snap_to_subpixel(float coordinate) {
+    return (int)floorf(coordinate * RASTER_SUBPIXEL_SCALE + 0.5f);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Floor division by the subpixel scale, which also rounds negative values down
+///////////////////////////////////////////////////////////////////////////////
+static int64_t floor_to_pixel(int64_t value) {
+    int64_t pixel = value / RASTER_SUBPIXEL_SCALE;
+    return (value % RASTER_SUBPIXEL_SCALE < 0) ? pixel - 1 : pixel;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Set up the edges once per triangle, flipping them for counter-clockwise
+// triangles so inside pixels are always non-negative. Returns false when the
+// triangle has no area or covers no pixel center inside the clip rectangle.
+//
+// Pixel centers exactly on an edge follow the top-left rule: they belong to
+// the triangle only when the edge is a left edge, or a horizontal edge above
+// the inside. Two triangles sharing an edge see it from opposite sides, so
+// exactly one of them draws those pixels. Other edges take a bias of one so
+// the inside test stays e >= 0.
+//
+// The fixed point values are divided back to whole pixel steps, rounding
+// down, so the per-pixel edge values stay small enough for 32-bit lanes on
+// any screen size. The sign of an edge value survives rounding down, and the
+// pixel steps in fixed point are exact multiples of the subpixel scale.
+///////////////////////////////////////////////////////////////////////////////
+static bool setup_edges(edge_setup_t* s, float fx0, float fy0, float fx1, float fy1, float fx2, float fy2, rect_t clip) {
+    int x[3] = { snap_to_subpixel(fx0), snap_to_subpixel(fx1), snap_to_subpixel(fx2) };
+    int y[3] = { snap_to_subpixel(fy0), snap_to_subpixel(fy1), snap_to_subpixel(fy2) };
+    int64_t area = edge_function(x[0], y[0], x[1], y[1], x[2], y[2]);
+    if (area == 0) {
+        return false;
+    }
+    int sign = area > 0 ? 1 : -1;
+
+    // Pixels whose centers fall inside the snapped vertex extents
+    int x_lo = x[0] < x[1] ? (x[0] < x[2] ? x[0] : x[2]) : (x[1] < x[2] ? x[1] : x[2]);
+    int x_hi = x[0] > x[1] ? (x[0] > x[2] ? x[0] : x[2]) : (x[1] > x[2] ? x[1] : x[2]);
+    int y_lo = y[0] < y[1] ? (y[0] < y[2] ? y[0] : y[2]) : (y[1] < y[2] ? y[1] : y[2]);
+    int y_hi = y[0] > y[1] ? (y[0] > y[2] ? y[0] : y[2]) : (y[1] > y[2] ? y[1] : y[2]);
+    int half = RASTER_SUBPIXEL_SCALE / 2;
+    s->x_min = (int)floor_to_pixel(x_lo - half + RASTER_SUBPIXEL_SCALE - 1);
+    s->x_max = (int)floor_to_pixel(x_hi - half);
+    s->y_min = (int)floor_to_pixel(y_lo - half + RASTER_SUBPIXEL_SCALE - 1);
+    s->y_max = (int)floor_to_pixel(y_hi - half);
+    if (s->x_min < 0) s->x_min = 0;
+    if (s->y_min < 0) s->y_min = 0;
+    if (s->x_max > window_width - 1) s->x_max = window_width - 1;
+    if (s->y_max > window_height - 1) s->y_max = window_height - 1;
+    s->x_first = s->x_min > clip.x_min ? s->x_min : clip.x_min;
+    s->y_first = s->y_min > clip.y_min ? s->y_min : clip.y_min;
+    s->x_last = s->x_max < clip.x_max ? s->x_max : clip.x_max;
+    s->y_last = s->y_max < clip.y_max ? s->y_max : clip.y_max;
+    if (s->x_first > s->x_last || s->y_first > s->y_last) {
+        return false;
+    }
+
+    // Center of the first pixel in fixed point
+    int64_t px = (int64_t)s->x_min * RASTER_SUBPIXEL_SCALE + half;
+    int64_t py = (int64_t)s->y_min * RASTER_SUBPIXEL_SCALE + half;
+
+    // Edge i is opposite vertex i, going from vertex a to vertex b
+    for (int i = 0; i < 3; i++) {
+        int a = (i + 1) % 3;
+        int b = (i + 2) % 3;
+        s->e_dx[i] = sign * (y[a] - y[b]);
+        s->e_dy[i] = sign * (x[b] - x[a]);
+        bool top_left = s->e_dx[i] > 0 || (s->e_dx[i] == 0 && s->e_dy[i] > 0);
+        int64_t e = sign * edge_function(x[a], y[a], x[b], y[b], px, py) - (top_left ? 0 : 1);
+        s->e_row[i] = (int)floor_to_pixel(e) + (s->y_first - s->y_min) * s->e_dy[i];
+    }
+
+    for (int i = 0; i < 3; i++) {
+        s->vertex_x[i] = (float)x[i] / RASTER_SUBPIXEL_SCALE;
+        s->vertex_y[i] = (float)y[i] / RASTER_SUBPIXEL_SCALE;
+    }
+    s->inv_area = (float)RASTER_SUBPIXEL_SCALE * RASTER_SUBPIXEL_SCALE / area;
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// An attribute interpolated linearly in screen space over the snapped
+// triangle, as its value at the center of the first pixel of the bounding
+// box and its steps for one pixel to the right and one row down
+///////////////////////////////////////////////////////////////////////////////
+typedef struct {
+    float start;
+    float dx;
+    float dy;
+} edge_attribute_t;
+
+static void setup_attribute(edge_attribute_t* attribute, edge_setup_t* s, float a0, float a1, float a2) {
+    float x10 = s->vertex_x[1] - s->vertex_x[0], y10 = s->vertex_y[1] - s->vertex_y[0];
+    float x20 = s->vertex_x[2] - s->vertex_x[0], y20 = s->vertex_y[2] - s->vertex_y[0];
+    attribute->dx = ((a1 - a0) * y20 - (a2 - a0) * y10) * s->inv_area;
+    attribute->dy = ((a2 - a0) * x10 - (a1 - a0) * x20) * s->inv_area;
+    attribute->start = a0 +
+        attribute->dx * (s->x_min + 0.5f - s->vertex_x[0]) +
+        attribute->dy * (s->y_min + 0.5f - s->vertex_y[0]);
+}
+
+static float attribute_at_row_start(edge_attribute_t* attribute, edge_setup_t* s, int y) {
+    return attribute->start + (y - s->y_min) * attribute->dy;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Check the clipped bounding box against the depth tiles. The box holds
+// exactly the pixel centers the triangle can cover, so it needs no margin.
+///////////////////////////////////////////////////////////////////////////////
+static bool box_occluded(edge_setup_t* s, float nearest_reciprocal_w) {
+    if (depth_region_occluded(s->x_first, s->y_first, s->x_last, s->y_last, nearest_reciprocal_w)) {
+        frame_stats.triangles_occluded++;
+        return true;
+    }
+    return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Find the covered run of the current row from the edge values at its start,
+// solving e + i * dx >= 0 for each edge instead of walking the pixels. The
+// triangle is convex, so the covered pixels of a row are contiguous. Returns
+// false when the row is empty.
+///////////////////////////////////////////////////////////////////////////////
+static bool covered_run(edge_setup_t* s, int* x_left, int* x_right) {
+    int first = 0;
+    int last = s->x_max - s->x_min;
+    for (int i = 0; i < 3; i++) {
+        int e = s->e_row[i];
+        int dx = s->e_dx[i];
+        if (dx > 0) {
+            // Inside from the first step where e catches up to zero
+            int step = e >= 0 ? 0 : (-e + dx - 1) / dx;
+            if (step > first) first = step;
+        } else if (dx < 0) {
+            // Inside until the last step before e drops below zero
+            if (e < 0) return false;
+            int step = e / -dx;
+            if (step < last) last = step;
+        } else if (e < 0) {
+            return false;
+        }
+    }
+    if (first > last) {
+        return false;
+    }
+    *x_left = s->x_min + first;
+    *x_right = s->x_min + last;
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Fill the pixels from x_start to x_end of row y with one color, in either
+// order, clamping the span to the screen once and storing whole vectors of
+// pixels. Returns how many pixels were written.
+///////////////////////////////////////////////////////////////////////////////
+int fill_span(int x_start, int x_end, int y, uint32_t color) {
+    if (x_end < x_start) {
+        int x = x_start;
+        x_start = x_end;
+        x_end = x;
+    }
+    if (y < 0 || y >= window_height) {
+        return 0;
+    }
+    if (x_start < 0) x_start = 0;
+    if (x_end > window_width - 1) x_end = window_width - 1;
+    if (x_start > x_end) {
+        return 0;
+    }
+
+    uint32_t* pixels = &color_buffer[(window_width * y) + x_start];
+    int count = x_end - x_start + 1;
+    int i = 0;
+#if RASTER_SIMD_WIDTH == 8
+    __m256i fill = _mm256_set1_epi32((int)color);
+    for (; i + 8 <= count; i += 8) {
+        _mm256_storeu_si256((__m256i*)(pixels + i), fill);
+    }
+#elif RASTER_SIMD_WIDTH == 4
+    __m128i fill = _mm_set1_epi32((int)color);
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_si128((__m128i*)(pixels + i), fill);
+    }
+#endif
+    for (; i < count; i++) {
+        pixels[i] = color;
+    }
+    return count;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Walk the bounding box row by row, shading the pixels where all three edge
+// values are non-negative. The triangle is convex, so a row ends as soon as a
+// pixel falls outside after the inside was reached. Without a depth test the
+// covered run of each row is found directly and filled as one span. Only the
+// pixels inside the clip rectangle are visited.
+///////////////////////////////////////////////////////////////////////////////
+void rasterize_filled_triangle(
+    float x0, float y0, float w0,
+    float x1, float y1, float w1,
+    float x2, float y2, float w2,
+    uint32_t color, rect_t clip
+) {
+    edge_setup_t s;
+    if (!setup_edges(&s, x0, y0, x1, y1, x2, y2, clip)) {
+        return;
+    }
+
+    bool test_depth = depth_method == DEPTH_BUFFER;
+    bool test_tiles = test_depth && use_depth_tiles;
+    float nearest_reciprocal_w = fmaxf(fmaxf(1 / w0, 1 / w1), 1 / w2);
+    if (test_tiles && box_occluded(&s, nearest_reciprocal_w)) {
+        return;
+    }
+
+    int pixels_shaded = 0;
+
+    // Without depth every covered pixel takes the color, so each row is one span fill
+    if (!test_depth) {
+        for (int y = s.y_first; y <= s.y_last; y++) {
+            int x_left, x_right;
+            if (covered_run(&s, &x_left, &x_right)) {
+                if (x_left < s.x_first) x_left = s.x_first;
+                if (x_right > s.x_last) x_right = s.x_last;
+                if (x_left <= x_right) {
+                    pixels_shaded += fill_span(x_left, x_right, y, color);
+                }
+            }
+            s.e_row[0] += s.e_dy[0];
+            s.e_row[1] += s.e_dy[1];
+            s.e_row[2] += s.e_dy[2];
+        }
+        frame_stats.pixels_shaded += pixels_shaded;
+        return;
+    }
+
+    edge_attribute_t reciprocal_w;
+    setup_attribute(&reciprocal_w, &s, 1 / w0, 1 / w1, 1 / w2);
+
+    for (int y = s.y_first; y <= s.y_last; y++) {
+        int e0 = s.e_row[0] + (s.x_first - s.x_min) * s.e_dx[0];
+        int e1 = s.e_row[1] + (s.x_first - s.x_min) * s.e_dx[1];
+        int e2 = s.e_row[2] + (s.x_first - s.x_min) * s.e_dx[2];
+        float q_row = attribute_at_row_start(&reciprocal_w, &s, y);
+        bool inside_reached = false;
+
+        for (int x = s.x_first; x <= s.x_last; x++, e0 += s.e_dx[0], e1 += s.e_dx[1], e2 += s.e_dx[2]) {
+            // Skip the rest of the depth tile when it is entirely in front of the triangle
+            if (test_tiles && (x == s.x_first || x % DEPTH_TILE_SIZE == 0)) {
+                int skipped = occluded_tile_span(x, s.x_last + 1, y, nearest_reciprocal_w);
+                if (skipped > 0) {
+                    x += skipped - 1;
+                    e0 += (skipped - 1) * s.e_dx[0];
+                    e1 += (skipped - 1) * s.e_dx[1];
+                    e2 += (skipped - 1) * s.e_dx[2];
+                    continue;
+                }
+            }
+
+            if ((e0 | e1 | e2) < 0) {
+                if (inside_reached) break;
+                continue;
+            }
+            inside_reached = true;
+
+            float q = q_row + (x - s.x_min) * reciprocal_w.dx;
+            if (test_depth && !depth_test(x, y, fminf(q, nearest_reciprocal_w))) {
+                continue;
+            }
+            color_buffer[(window_width * y) + x] = color;
+            pixels_shaded++;
+        }
+
+        s.e_row[0] += s.e_dy[0];
+        s.e_row[1] += s.e_dy[1];
+        s.e_row[2] += s.e_dy[2];
+    }
+    frame_stats.pixels_shaded += pixels_shaded;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Per-triangle state shared by the textured span kernels
+///////////////////////////////////////////////////////////////////////////////
+typedef struct {
+    edge_attribute_t reciprocal_w;
+    edge_attribute_t u_over_w;
+    edge_attribute_t v_over_w;
+    float nearest_reciprocal_w;
+    bool test_depth;
+    bool test_tiles;
+    bool affine;
+    texture_t* texture;
+} textured_setup_t;
+
+///////////////////////////////////////////////////////////////////////////////
+// Exact perspective correct texture coordinates of pixel x on a row
+///////////////////////////////////////////////////////////////////////////////
+static void texture_coordinates_at(
+    edge_setup_t* s, textured_setup_t* t, int x, float q_row, float uq_row, float vq_row, float* u, float* v
+) {
+    float w = 1 / (q_row + (x - s->x_min) * t->reciprocal_w.dx);
+    *u = (uq_row + (x - s->x_min) * t->u_over_w.dx) * w;
+    *v = (vq_row + (x - s->x_min) * t->v_over_w.dx) * w;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Affine subdivision of a row. The row is cut into segments at multiples of
+// RASTER_AFFINE_SPAN, clamped to the covered run so no segment extrapolates
+// past the triangle. The texture coordinates are exact at both ends of a
+// segment and interpolated linearly in between, while the depth test still
+// uses the exact 1/w of every pixel.
+///////////////////////////////////////////////////////////////////////////////
+typedef struct {
+    int x_left, x_right; // covered run of the row
+    int base;            // first pixel of the current segment cell, or -1 before the first
+    int start, end;      // current segment clamped to the covered run
+    float u_start, v_start;
+    float u_end, v_end;
+    float u_step, v_step;
+} affine_row_t;
+
+///////////////////////////////////////////////////////////////////////////////
+// Find the covered run of row y, returning false when the row is empty
+///////////////////////////////////////////////////////////////////////////////
+static bool affine_row_init(affine_row_t* row, edge_setup_t* s) {
+    if (!covered_run(s, &row->x_left, &row->x_right)) {
+        return false;
+    }
+    row->base = -1;
+    row->end = -1;
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Make the segment holding pixel x current, reusing the exact coordinates of
+// the previous segment end when the new one starts there. With stats enabled,
+// each segment measures the texel error at its midpoint, where affine
+// interpolation strays the most from the exact divide.
+///////////////////////////////////////////////////////////////////////////////
+static void affine_segment_at(
+    affine_row_t* row, edge_setup_t* s, textured_setup_t* t, int x, float q_row, float uq_row, float vq_row
+) {
+    int base = x - (x % RASTER_AFFINE_SPAN);
+    if (base == row->base) {
+        return;
+    }
+    int start = base > row->x_left ? base : row->x_left;
+    int end = base + RASTER_AFFINE_SPAN < row->x_right ? base + RASTER_AFFINE_SPAN : row->x_right;
+    if (start == row->end) {
+        row->u_start = row->u_end;
+        row->v_start = row->v_end;
+    } else {
+        texture_coordinates_at(s, t, start, q_row, uq_row, vq_row, &row->u_start, &row->v_start);
+    }
+    row->base = base;
+    row->start = start;
+    row->end = end;
+    row->u_step = row->v_step = 0;
+    if (end > start) {
+        // Whole segments divide by a constant power of two, which folds into an exact multiply
+        float inv_length = (end - start == RASTER_AFFINE_SPAN) ? 1.0f / RASTER_AFFINE_SPAN : 1.0f / (end - start);
+        texture_coordinates_at(s, t, end, q_row, uq_row, vq_row, &row->u_end, &row->v_end);
+        row->u_step = (row->u_end - row->u_start) * inv_length;
+        row->v_step = (row->v_end - row->v_start) * inv_length;
+    }
+
+    if (stats_enabled && end - start >= 2) {
+        texture_t* texture = t->texture;
+        int middle = start + (end - start) / 2;
+        float u_exact, v_exact;
+        texture_coordinates_at(s, t, middle, q_row, uq_row, vq_row, &u_exact, &v_exact);
+        float u_error = fabsf(row->u_start + (middle - start) * row->u_step - u_exact) * texture->width;
+        float v_error = fabsf(row->v_start + (middle - start) * row->v_step - v_exact) * texture->height;
+        float error = fmaxf(u_error, v_error);
+        frame_stats.affine_error_sum += error;
+        frame_stats.affine_error_samples++;
+        if (error > frame_stats.affine_error_max) {
+            frame_stats.affine_error_max = error;
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Shade the textured pixels of row y one at a time, from x_first to the end
+// of the clipped box, returning how many were written. The texture
+// coordinates come from the affine segments when a row is given.
+///////////////////////////////////////////////////////////////////////////////
+static int shade_textured_span(
+    edge_setup_t* s, textured_setup_t* t, affine_row_t* affine, int y, int x_first, float q_row, float uq_row, float vq_row
+) {
+    texture_t* texture = t->texture;
+    int e0 = s->e_row[0] + (x_first - s->x_min) * s->e_dx[0];
+    int e1 = s->e_row[1] + (x_first - s->x_min) * s->e_dx[1];
+    int e2 = s->e_row[2] + (x_first - s->x_min) * s->e_dx[2];
+    bool inside_reached = false;
+    int pixels_shaded = 0;
+
+    for (int x = x_first; x <= s->x_last; x++, e0 += s->e_dx[0], e1 += s->e_dx[1], e2 += s->e_dx[2]) {
+        // Skip the rest of the depth tile when it is entirely in front of the triangle
+        if (t->test_tiles && (x == x_first || x % DEPTH_TILE_SIZE == 0)) {
+            int skipped = occluded_tile_span(x, s->x_last + 1, y, t->nearest_reciprocal_w);
+            if (skipped > 0) {
+                x += skipped - 1;
+                e0 += (skipped - 1) * s->e_dx[0];
+                e1 += (skipped - 1) * s->e_dx[1];
+                e2 += (skipped - 1) * s->e_dx[2];
+                continue;
+            }
+        }
+
+        if ((e0 | e1 | e2) < 0) {
+            if (inside_reached) break;
+            continue;
+        }
+        inside_reached = true;
+
+        // Reject hidden pixels before fetching the texel
+        float q = q_row + (x - s->x_min) * t->reciprocal_w.dx;
+        if (t->test_depth && !depth_test(x, y, fminf(q, t->nearest_reciprocal_w))) {
+            continue;
+        }
+
+        // Divide back by 1/w and map the UV coordinate to the texture, wrapping the rare
+        // coordinates at or past its edges without paying an integer divide for the rest
+        float u, v;
+        if (affine != NULL) {
+            affine_segment_at(affine, s, t, x, q_row, uq_row, vq_row);
+            u = affine->u_start + (x - affine->start) * affine->u_step;
+            v = affine->v_start + (x - affine->start) * affine->v_step;
+        } else {
+            u = (uq_row + (x - s->x_min) * t->u_over_w.dx) / q;
+            v = (vq_row + (x - s->x_min) * t->v_over_w.dx) / q;
+        }
+        int tex_x = abs((int)(u * texture->width));
+        int tex_y = abs((int)(v * texture->height));
+        if (tex_x >= texture->width) tex_x %= texture->width;
+        if (tex_y >= texture->height) tex_y %= texture->height;
+
+        color_buffer[(window_width * y) + x] = texture->pixels[(texture->width * tex_y) + tex_x];
+        pixels_shaded++;
+    }
+    return pixels_shaded;
+}
+
+#if RASTER_SIMD_WIDTH > 1
+static int count_lanes(int mask) {
+    int count = 0;
+    for (; mask != 0; mask &= mask - 1) {
+        count++;
+    }
+    return count;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Wrap the texel coordinates of the lanes at or past the texture edges, the
+// same way the scalar span does. Only called when some lane needs it.
+///////////////////////////////////////////////////////////////////////////////
+static void wrap_texel_lanes(int* tex_x, int* tex_y, texture_t* texture) {
+    for (int i = 0; i < RASTER_SIMD_WIDTH; i++) {
+        if (tex_x[i] >= texture->width) tex_x[i] %= texture->width;
+        if (tex_y[i] >= texture->height) tex_y[i] %= texture->height;
+    }
+}
+#endif
+
+#if RASTER_SIMD_WIDTH == 8
+///////////////////////////////////////////////////////////////////////////////
+// AVX2 kernel, 8 pixels per iteration. Groups are aligned to 8 pixels so each
+// one is exactly one depth tile, and lanes outside the triangle or its
+// clipped box are masked off the depth and color stores. The attributes are
+// evaluated with the same operations as the scalar span, giving identical
+// pixels.
+///////////////////////////////////////////////////////////////////////////////
+static int shade_textured_span_simd(
+    edge_setup_t* s, textured_setup_t* t, affine_row_t* affine, int y, float q_row, float uq_row, float vq_row
+) {
+    texture_t* texture = t->texture;
+    const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i box_before = _mm256_set1_epi32(s->x_first - s->x_min - 1);
+    const __m256i box_after = _mm256_set1_epi32(s->x_last - s->x_min + 1);
+    const __m256i tex_width = _mm256_set1_epi32(texture->width);
+    const __m256i tex_last_x = _mm256_set1_epi32(texture->width - 1);
+    const __m256i tex_last_y = _mm256_set1_epi32(texture->height - 1);
+    const __m256 nearest = _mm256_set1_ps(t->nearest_reciprocal_w);
+
+    int x = s->x_first & ~7;
+    __m256i offset = _mm256_add_epi32(_mm256_set1_epi32(x - s->x_min), lane);
+    __m256i e0 = _mm256_add_epi32(_mm256_set1_epi32(s->e_row[0]), _mm256_mullo_epi32(offset, _mm256_set1_epi32(s->e_dx[0])));
+    __m256i e1 = _mm256_add_epi32(_mm256_set1_epi32(s->e_row[1]), _mm256_mullo_epi32(offset, _mm256_set1_epi32(s->e_dx[1])));
+    __m256i e2 = _mm256_add_epi32(_mm256_set1_epi32(s->e_row[2]), _mm256_mullo_epi32(offset, _mm256_set1_epi32(s->e_dx[2])));
+    const __m256i e0_step = _mm256_set1_epi32(8 * s->e_dx[0]);
+    const __m256i e1_step = _mm256_set1_epi32(8 * s->e_dx[1]);
+    const __m256i e2_step = _mm256_set1_epi32(8 * s->e_dx[2]);
+    const __m256i offset_step = _mm256_set1_epi32(8);
+    bool inside_reached = false;
+    int pixels_shaded = 0;
+
+    for (; x <= s->x_last; x += 8, offset = _mm256_add_epi32(offset, offset_step),
+         e0 = _mm256_add_epi32(e0, e0_step), e1 = _mm256_add_epi32(e1, e1_step), e2 = _mm256_add_epi32(e2, e2_step)) {
+        // A group hanging past the right of the window would load and store outside the row
+        if (x + 8 > window_width) {
+            return pixels_shaded + shade_textured_span(s, t, affine, y, x > s->x_first ? x : s->x_first, q_row, uq_row, vq_row);
+        }
+
+        // Coverage: all edge values non-negative, inside the clipped box
+        __m256i in_box = _mm256_and_si256(_mm256_cmpgt_epi32(offset, box_before), _mm256_cmpgt_epi32(box_after, offset));
+        __m256i outside = _mm256_srai_epi32(_mm256_or_si256(_mm256_or_si256(e0, e1), e2), 31);
+        __m256 mask = _mm256_castsi256_ps(_mm256_andnot_si256(outside, in_box));
+        int covered = _mm256_movemask_ps(mask);
+        if (covered == 0) {
+            if (inside_reached) break;
+            continue;
+        }
+        inside_reached = true;
+
+        // Skip the group when its depth tile is entirely in front of the triangle
+        if (t->test_tiles && depth_tile_occluded(x, y, t->nearest_reciprocal_w)) {
+            frame_stats.pixels_tile_skipped += count_lanes(covered);
+            continue;
+        }
+
+        __m256 offset_f = _mm256_cvtepi32_ps(offset);
+        __m256 q = _mm256_add_ps(_mm256_set1_ps(q_row), _mm256_mul_ps(offset_f, _mm256_set1_ps(t->reciprocal_w.dx)));
+
+        // Reject hidden pixels before fetching the texels
+        if (t->test_depth) {
+            float* depth = &z_buffer[(window_width * y) + x];
+            __m256 clamped = _mm256_min_ps(q, nearest);
+            mask = _mm256_and_ps(mask, _mm256_cmp_ps(clamped, _mm256_loadu_ps(depth), _CMP_GT_OQ));
+            int passed = _mm256_movemask_ps(mask);
+            frame_stats.pixels_depth_tested += count_lanes(covered);
+            frame_stats.pixels_depth_rejected += count_lanes(covered & ~passed);
+            if (passed == 0) {
+                continue;
+            }
+            _mm256_maskstore_ps(depth, _mm256_castps_si256(mask), clamped);
+            mark_depth_tile_dirty(x, y);
+        }
+
+        __m256 u, v;
+        if (affine != NULL) {
+            // The group is aligned inside one segment, so the lanes step from its start
+            affine_segment_at(affine, s, t, x, q_row, uq_row, vq_row);
+            __m256 segment_offset = _mm256_cvtepi32_ps(_mm256_sub_epi32(offset, _mm256_set1_epi32(affine->start - s->x_min)));
+            u = _mm256_add_ps(_mm256_set1_ps(affine->u_start), _mm256_mul_ps(segment_offset, _mm256_set1_ps(affine->u_step)));
+            v = _mm256_add_ps(_mm256_set1_ps(affine->v_start), _mm256_mul_ps(segment_offset, _mm256_set1_ps(affine->v_step)));
+        } else {
+            __m256 uq = _mm256_add_ps(_mm256_set1_ps(uq_row), _mm256_mul_ps(offset_f, _mm256_set1_ps(t->u_over_w.dx)));
+            __m256 vq = _mm256_add_ps(_mm256_set1_ps(vq_row), _mm256_mul_ps(offset_f, _mm256_set1_ps(t->v_over_w.dx)));
+            u = _mm256_div_ps(uq, q);
+            v = _mm256_div_ps(vq, q);
+        }
+        __m256i tex_x = _mm256_abs_epi32(_mm256_cvttps_epi32(_mm256_mul_ps(u, _mm256_set1_ps((float)texture->width))));
+        __m256i tex_y = _mm256_abs_epi32(_mm256_cvttps_epi32(_mm256_mul_ps(v, _mm256_set1_ps((float)texture->height))));
+        __m256i past_edge = _mm256_or_si256(_mm256_cmpgt_epi32(tex_x, tex_last_x), _mm256_cmpgt_epi32(tex_y, tex_last_y));
+        if (_mm256_movemask_ps(_mm256_and_ps(_mm256_castsi256_ps(past_edge), mask)) != 0) {
+            int lanes_x[8], lanes_y[8];
+            _mm256_storeu_si256((__m256i*)lanes_x, tex_x);
+            _mm256_storeu_si256((__m256i*)lanes_y, tex_y);
+            wrap_texel_lanes(lanes_x, lanes_y, texture);
+            tex_x = _mm256_loadu_si256((__m256i*)lanes_x);
+            tex_y = _mm256_loadu_si256((__m256i*)lanes_y);
+        }
+
+        __m256i texel_index = _mm256_add_epi32(_mm256_mullo_epi32(tex_y, tex_width), tex_x);
+        __m256i texels = _mm256_mask_i32gather_epi32(
+            _mm256_setzero_si256(), (const int*)texture->pixels, texel_index, _mm256_castps_si256(mask), 4
+        );
+        _mm256_maskstore_epi32((int*)&color_buffer[(window_width * y) + x], _mm256_castps_si256(mask), texels);
+        pixels_shaded += count_lanes(_mm256_movemask_ps(mask));
+    }
+    return pixels_shaded;
+}
+#elif RASTER_SIMD_WIDTH == 4
+///////////////////////////////////////////////////////////////////////////////
+// SSE2 kernel, 4 pixels per iteration, in 4-pixel aligned groups that never
+// straddle a depth tile. SSE2 has no gather or masked store, so the texels
+// are fetched per lane and the stores blend with the pixels already there.
+///////////////////////////////////////////////////////////////////////////////
+static __m128i abs_epi32(__m128i a) {
+    __m128i sign = _mm_srai_epi32(a, 31);
+    return _mm_sub_epi32(_mm_xor_si128(a, sign), sign);
+}
+
+static int shade_textured_span_simd(
+    edge_setup_t* s, textured_setup_t* t, affine_row_t* affine, int y, float q_row, float uq_row, float vq_row
+) {
+    texture_t* texture = t->texture;
+    const __m128i lane = _mm_setr_epi32(0, 1, 2, 3);
+    const __m128i box_before = _mm_set1_epi32(s->x_first - s->x_min - 1);
+    const __m128i box_after = _mm_set1_epi32(s->x_last - s->x_min + 1);
+    const __m128i tex_last_x = _mm_set1_epi32(texture->width - 1);
+    const __m128i tex_last_y = _mm_set1_epi32(texture->height - 1);
+    const __m128 nearest = _mm_set1_ps(t->nearest_reciprocal_w);
+
+    // SSE2 has no 32-bit multiply, so the edge steps across the lanes are set directly
+    int x = s->x_first & ~3;
+    __m128i offset = _mm_add_epi32(_mm_set1_epi32(x - s->x_min), lane);
+    __m128i e[3], e_step[3];
+    for (int i = 0; i < 3; i++) {
+        int dx = s->e_dx[i];
+        e[i] = _mm_add_epi32(_mm_set1_epi32(s->e_row[i] + (x - s->x_min) * dx), _mm_setr_epi32(0, dx, 2 * dx, 3 * dx));
+        e_step[i] = _mm_set1_epi32(4 * dx);
+    }
+    const __m128i offset_step = _mm_set1_epi32(4);
+    bool inside_reached = false;
+    int pixels_shaded = 0;
+
+    for (; x <= s->x_last; x += 4, offset = _mm_add_epi32(offset, offset_step),
+         e[0] = _mm_add_epi32(e[0], e_step[0]), e[1] = _mm_add_epi32(e[1], e_step[1]), e[2] = _mm_add_epi32(e[2], e_step[2])) {
+        // A group hanging past the right of the window would load and store outside the row
+        if (x + 4 > window_width) {
+            return pixels_shaded + shade_textured_span(s, t, affine, y, x > s->x_first ? x : s->x_first, q_row, uq_row, vq_row);
+        }
+
+        // Coverage: all edge values non-negative, inside the clipped box
+        __m128i in_box = _mm_and_si128(_mm_cmpgt_epi32(offset, box_before), _mm_cmpgt_epi32(box_after, offset));
+        __m128i outside = _mm_srai_epi32(_mm_or_si128(_mm_or_si128(e[0], e[1]), e[2]), 31);
+        __m128 mask = _mm_castsi128_ps(_mm_andnot_si128(outside, in_box));
+        int covered = _mm_movemask_ps(mask);
+        if (covered == 0) {
+            if (inside_reached) break;
+            continue;
+        }
+        inside_reached = true;
+
+        // Skip the group when its depth tile is entirely in front of the triangle
+        if (t->test_tiles && depth_tile_occluded(x, y, t->nearest_reciprocal_w)) {
+            frame_stats.pixels_tile_skipped += count_lanes(covered);
+            continue;
+        }
+
+        __m128 offset_f = _mm_cvtepi32_ps(offset);
+        __m128 q = _mm_add_ps(_mm_set1_ps(q_row), _mm_mul_ps(offset_f, _mm_set1_ps(t->reciprocal_w.dx)));
+
+        // Reject hidden pixels before fetching the texels
+        if (t->test_depth) {
+            float* depth = &z_buffer[(window_width * y) + x];
+            __m128 stored = _mm_loadu_ps(depth);
+            __m128 clamped = _mm_min_ps(q, nearest);
+            mask = _mm_and_ps(mask, _mm_cmpgt_ps(clamped, stored));
+            int passed = _mm_movemask_ps(mask);
+            frame_stats.pixels_depth_tested += count_lanes(covered);
+            frame_stats.pixels_depth_rejected += count_lanes(covered & ~passed);
+            if (passed == 0) {
+                continue;
+            }
+            _mm_storeu_ps(depth, _mm_or_ps(_mm_and_ps(mask, clamped), _mm_andnot_ps(mask, stored)));
+            mark_depth_tile_dirty(x, y);
+        }
+
+        __m128 u, v;
+        if (affine != NULL) {
+            // The group is aligned inside one segment, so the lanes step from its start
+            affine_segment_at(affine, s, t, x, q_row, uq_row, vq_row);
+            __m128 segment_offset = _mm_cvtepi32_ps(_mm_sub_epi32(offset, _mm_set1_epi32(affine->start - s->x_min)));
+            u = _mm_add_ps(_mm_set1_ps(affine->u_start), _mm_mul_ps(segment_offset, _mm_set1_ps(affine->u_step)));
+            v = _mm_add_ps(_mm_set1_ps(affine->v_start), _mm_mul_ps(segment_offset, _mm_set1_ps(affine->v_step)));
+        } else {
+            __m128 uq = _mm_add_ps(_mm_set1_ps(uq_row), _mm_mul_ps(offset_f, _mm_set1_ps(t->u_over_w.dx)));
+            __m128 vq = _mm_add_ps(_mm_set1_ps(vq_row), _mm_mul_ps(offset_f, _mm_set1_ps(t->v_over_w.dx)));
+            u = _mm_div_ps(uq, q);
+            v = _mm_div_ps(vq, q);
+        }
+        __m128i tex_x = abs_epi32(_mm_cvttps_epi32(_mm_mul_ps(u, _mm_set1_ps((float)texture->width))));
+        __m128i tex_y = abs_epi32(_mm_cvttps_epi32(_mm_mul_ps(v, _mm_set1_ps((float)texture->height))));
+        int lanes_x[4], lanes_y[4];
+        _mm_storeu_si128((__m128i*)lanes_x, tex_x);
+        _mm_storeu_si128((__m128i*)lanes_y, tex_y);
+        __m128i past_edge = _mm_or_si128(_mm_cmpgt_epi32(tex_x, tex_last_x), _mm_cmpgt_epi32(tex_y, tex_last_y));
+        int write = _mm_movemask_ps(mask);
+        if ((_mm_movemask_ps(_mm_castsi128_ps(past_edge)) & write) != 0) {
+            wrap_texel_lanes(lanes_x, lanes_y, texture);
+        }
+
+        uint32_t* pixels = &color_buffer[(window_width * y) + x];
+        for (int i = 0; i < 4; i++) {
+            if (write & (1 << i)) {
+                pixels[i] = texture->pixels[(texture->width * lanes_y[i]) + lanes_x[i]];
+            }
+        }
+        pixels_shaded += count_lanes(write);
+    }
+    return pixels_shaded;
+}
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// Same traversal as the filled triangle, with u/w, v/w, and 1/w set up once
+// per triangle. Each pixel evaluates them as the row start plus a multiple of
+// their step, so skipped tiles cannot change the result, and only pays the
+// divide back by 1/w for the perspective correct texture coordinates. Rows go
+// through the widest SIMD kernel compiled in, with affine subdivision instead
+// of the per-pixel divide in the approximate textured mode. The affine
+// segments are cut from the whole covered run, so clipping leaves them alone.
+///////////////////////////////////////////////////////////////////////////////
+void rasterize_textured_triangle(
+    float x0, float y0, float w0, float u0, float v0,
+    float x1, float y1, float w1, float u1, float v1,
+    float x2, float y2, float w2, float u2, float v2,
+    texture_t* texture, rect_t clip
+) {
+    edge_setup_t s;
+    if (!setup_edges(&s, x0, y0, x1, y1, x2, y2, clip)) {
+        return;
+    }
+
+    textured_setup_t t;
+    t.texture = texture;
+    t.affine = render_method == RENDER_TEXTURED_AFFINE;
+    t.test_depth = depth_method == DEPTH_BUFFER;
+    t.test_tiles = t.test_depth && use_depth_tiles;
+    t.nearest_reciprocal_w = fmaxf(fmaxf(1 / w0, 1 / w1), 1 / w2);
+    if (t.test_tiles && box_occluded(&s, t.nearest_reciprocal_w)) {
+        return;
+    }
+
+    setup_attribute(&t.reciprocal_w, &s, 1 / w0, 1 / w1, 1 / w2);
+    setup_attribute(&t.u_over_w, &s, u0 / w0, u1 / w1, u2 / w2);
+    setup_attribute(&t.v_over_w, &s, v0 / w0, v1 / w1, v2 / w2);
+
+    int pixels_shaded = 0;
+    for (int y = s.y_first; y <= s.y_last; y++) {
+        float q_row = attribute_at_row_start(&t.reciprocal_w, &s, y);
+        float uq_row = attribute_at_row_start(&t.u_over_w, &s, y);
+        float vq_row = attribute_at_row_start(&t.v_over_w, &s, y);
+        affine_row_t affine_row;
+        affine_row_t* affine = NULL;
+        if (t.affine && affine_row_init(&affine_row, &s)) {
+            affine = &affine_row;
+        }
+#if RASTER_SIMD_WIDTH > 1
+        pixels_shaded += shade_textured_span_simd(&s, &t, affine, y, q_row, uq_row, vq_row);
+#else
+        pixels_shaded += shade_textured_span(&s, &t, affine, y, s.x_first, q_row, uq_row, vq_row);
+#endif
+
+        s.e_row[0] += s.e_dy[0];
+        s.e_row[1] += s.e_dy[1];
+        s.e_row[2] += s.e_dy[2];
+    }
+    frame_stats.pixels_shaded += pixels_shaded;
+}
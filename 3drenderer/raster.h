@@ -0,0 +1,41 @@
+#ifndef RASTER_H
+#define RASTER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "display.h"
+#include "texture.h"
+
+#if defined(__AVX2__)
+#define RASTER_SIMD_WIDTH 8
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RASTER_SIMD_WIDTH 4
+#else
+#define RASTER_SIMD_WIDTH 1
+#endif
+
+// Fractional bits of the snapped vertex positions. Per-pixel edge values grow
+// with this scale times the screen area, and must fit 32-bit lanes.
+#define RASTER_SUBPIXEL_BITS 4
+
+// Pixels between exact perspective divides in the affine subdivision mode
+#define RASTER_AFFINE_SPAN 16
+
+int fill_span(int x_start, int x_end, int y, uint32_t color);
+int occluded_tile_span(int x, int x_end, int y, float nearest_reciprocal_w);
+bool triangle_occluded(int x0, int y0, int x1, int y1, int x2, int y2, float nearest_reciprocal_w);
+
+void rasterize_filled_triangle(
+    float x0, float y0, float w0,
+    float x1, float y1, float w1,
+    float x2, float y2, float w2,
+    uint32_t color, rect_t clip
+);
+void rasterize_textured_triangle(
+    float x0, float y0, float w0, float u0, float v0,
+    float x1, float y1, float w1, float u1, float v1,
+    float x2, float y2, float w2, float u2, float v2,
+    texture_t* texture, rect_t clip
+);
+
+#endif
@@ -0,0 +1,81 @@
+#include <stdio.h>
+#include <string.h>
+#include "array.h"
+#include "scene.h"
+
+scene_t scene = {
+    .num_meshes = 0,
+    .root = NULL,
+    .instances = NULL,
+    .max_vertices_per_mesh = 0
+};
+
+void init_scene(void) {
+    scene.root = node_create(NULL);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Reserve the next mesh slot, or return NULL when the scene is full
+///////////////////////////////////////////////////////////////////////////////
+static mesh_t* scene_next_mesh(void) {
+    if (scene.num_meshes == MAX_NUM_MESHES) {
+        printf("Error loading mesh: the scene already has %d meshes.\n", MAX_NUM_MESHES);
+        return NULL;
+    }
+    mesh_t* mesh = &scene.meshes[scene.num_meshes];
+    memset(mesh, 0, sizeof(mesh_t));
+    return mesh;
+}
+
+static mesh_t* scene_finish_mesh(mesh_t* mesh, char* png_filename) {
+    if (png_filename != NULL) {
+        load_png_texture_data(&mesh->texture, png_filename);
+    }
+    int num_vertices = array_length(mesh->vertices);
+    if (num_vertices > scene.max_vertices_per_mesh) {
+        scene.max_vertices_per_mesh = num_vertices;
+    }
+    scene.num_meshes++;
+    return mesh;
+}
+
+mesh_t* load_cube_mesh(char* png_filename) {
+    mesh_t* mesh = scene_next_mesh();
+    if (mesh == NULL) {
+        return NULL;
+    }
+    load_cube_mesh_data(mesh);
+    return scene_finish_mesh(mesh, png_filename);
+}
+
+mesh_t* load_obj_mesh(char* obj_filename, char* png_filename) {
+    mesh_t* mesh = scene_next_mesh();
+    if (mesh == NULL) {
+        return NULL;
+    }
+    load_obj_file_data(mesh, obj_filename);
+    return scene_finish_mesh(mesh, png_filename);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Create a node drawing the mesh under parent (or under the root when NULL)
+///////////////////////////////////////////////////////////////////////////////
+node_t* add_mesh_instance(mesh_t* mesh, node_t* parent) {
+    node_t* node = node_create(mesh);
+    node_add_child(parent != NULL ? parent : scene.root, node);
+    array_push(scene.instances, node);
+    return node;
+}
+
+void free_scene(void) {
+    if (scene.root != NULL) {
+        node_destroy(scene.root);
+        scene.root = NULL;
+    }
+    array_free(scene.instances);
+    scene.instances = NULL;
+    for (int i = 0; i < scene.num_meshes; i++) {
+        free_mesh_data(&scene.meshes[i]);
+    }
+    scene.num_meshes = 0;
+}
@@ -0,0 +1,30 @@
+#ifndef SCENE_H
+#define SCENE_H
+
+#include "mesh.h"
+#include "node.h"
+
+#define MAX_NUM_MESHES 16
+
+////////////////////////////////////////////////////////////////////////////////
+// A scene owns the meshes and a graph of nodes placing them in the world.
+// Every node with a mesh is an instance; instances share the mesh vertices,
+// faces, bounds, and texture, and only add their own transform.
+////////////////////////////////////////////////////////////////////////////////
+typedef struct {
+    mesh_t meshes[MAX_NUM_MESHES]; // geometry loaded once and shared by instances
+    int num_meshes;
+    node_t* root;                  // root of the scene graph
+    node_t** instances;            // dynamic array of the nodes that draw a mesh
+    int max_vertices_per_mesh;     // size needed for a per-mesh vertex cache
+} scene_t;
+
+extern scene_t scene;
+
+void init_scene(void);
+mesh_t* load_cube_mesh(char* png_filename);
+mesh_t* load_obj_mesh(char* obj_filename, char* png_filename);
+node_t* add_mesh_instance(mesh_t* mesh, node_t* parent);
+void free_scene(void);
+
+#endif
@@ -0,0 +1,106 @@
+#include <string.h>
+#include "sort.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Map the bits of a float into a uint32 that compares in the same order:
+// positive values get the sign bit set, negative values get all bits flipped
+///////////////////////////////////////////////////////////////////////////////
+uint32_t float_to_sortable_key(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return (bits & 0x80000000) ? ~bits : (bits | 0x80000000);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// LSD radix sort of key/index pairs in ascending key order, one byte per pass.
+// Passes where every key has the same byte are skipped. The result is stable
+// and ends up back in keys/indices.
+///////////////////////////////////////////////////////////////////////////////
+void radix_sort_pairs(uint32_t* keys, uint32_t* indices, uint32_t* temp_keys, uint32_t* temp_indices, int count) {
+    int histograms[4][256] = {{ 0 }};
+    for (int i = 0; i < count; i++) {
+        uint32_t key = keys[i];
+        histograms[0][key & 0xFF]++;
+        histograms[1][(key >> 8) & 0xFF]++;
+        histograms[2][(key >> 16) & 0xFF]++;
+        histograms[3][key >> 24]++;
+    }
+
+    uint32_t* src_keys = keys;
+    uint32_t* src_indices = indices;
+    uint32_t* dst_keys = temp_keys;
+    uint32_t* dst_indices = temp_indices;
+
+    for (int pass = 0; pass < 4; pass++) {
+        int shift = pass * 8;
+        int* histogram = histograms[pass];
+        if (count == 0 || histogram[(src_keys[0] >> shift) & 0xFF] == count) {
+            continue;
+        }
+
+        // Turn the counts into the starting offset of each bucket
+        int offset = 0;
+        for (int b = 0; b < 256; b++) {
+            int bucket_count = histogram[b];
+            histogram[b] = offset;
+            offset += bucket_count;
+        }
+
+        for (int i = 0; i < count; i++) {
+            int dst = histogram[(src_keys[i] >> shift) & 0xFF]++;
+            dst_keys[dst] = src_keys[i];
+            dst_indices[dst] = src_indices[i];
+        }
+
+        uint32_t* swap_keys = src_keys;
+        uint32_t* swap_indices = src_indices;
+        src_keys = dst_keys;
+        src_indices = dst_indices;
+        dst_keys = swap_keys;
+        dst_indices = swap_indices;
+    }
+
+    if (src_keys != keys) {
+        memcpy(keys, src_keys, sizeof(uint32_t) * count);
+        memcpy(indices, src_indices, sizeof(uint32_t) * count);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Return the order to draw the triangles back to front (painter's algorithm).
+// The keys are flipped so the farthest avg_depth sorts first. The keys and
+// indices are allocated from the arena and live until it is reset.
+///////////////////////////////////////////////////////////////////////////////
+uint32_t* sort_triangles_by_depth(arena_t* arena, triangle_t* triangles, int count) {
+    uint32_t* keys = (uint32_t*)arena_alloc(arena, sizeof(uint32_t) * count);
+    uint32_t* indices = (uint32_t*)arena_alloc(arena, sizeof(uint32_t) * count);
+    uint32_t* temp_keys = (uint32_t*)arena_alloc(arena, sizeof(uint32_t) * count);
+    uint32_t* temp_indices = (uint32_t*)arena_alloc(arena, sizeof(uint32_t) * count);
+
+    for (int i = 0; i < count; i++) {
+        keys[i] = ~float_to_sortable_key(triangles[i].avg_depth);
+        indices[i] = i;
+    }
+
+    radix_sort_pairs(keys, indices, temp_keys, temp_indices, count);
+    return indices;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Return the indices of the depths ordered nearest first, allocated from the
+// arena like the triangle order
+///////////////////////////////////////////////////////////////////////////////
+uint32_t* sort_front_to_back(arena_t* arena, float* depths, int count) {
+    uint32_t* keys = (uint32_t*)arena_alloc(arena, sizeof(uint32_t) * count);
+    uint32_t* indices = (uint32_t*)arena_alloc(arena, sizeof(uint32_t) * count);
+    uint32_t* temp_keys = (uint32_t*)arena_alloc(arena, sizeof(uint32_t) * count);
+    uint32_t* temp_indices = (uint32_t*)arena_alloc(arena, sizeof(uint32_t) * count);
+
+    for (int i = 0; i < count; i++) {
+        keys[i] = float_to_sortable_key(depths[i]);
+        indices[i] = i;
+    }
+
+    radix_sort_pairs(keys, indices, temp_keys, temp_indices, count);
+    return indices;
+}
@@ -0,0 +1,13 @@
+#ifndef SORT_H
+#define SORT_H
+
+#include <stdint.h>
+#include "arena.h"
+#include "triangle.h"
+
+uint32_t float_to_sortable_key(float value);
+void radix_sort_pairs(uint32_t* keys, uint32_t* indices, uint32_t* temp_keys, uint32_t* temp_indices, int count);
+uint32_t* sort_triangles_by_depth(arena_t* arena, triangle_t* triangles, int count);
+uint32_t* sort_front_to_back(arena_t* arena, float* depths, int count);
+
+#endif
@@ -0,0 +1,145 @@
+#include <stdio.h>
+#include <string.h>
+#include <SDL2/SDL.h>
+#include "job.h"
+#include "raster.h"
+#include "stats.h"
+
+THREAD_LOCAL frame_stats_t frame_stats;
+bool stats_enabled = false;
+
+static frame_stats_t totals;
+static int frames_counted = 0;
+static Uint32 report_start_time = 0;
+static Uint64 previous_frame_end = 0;
+
+#define AVERAGE(counter) ((double)totals.counter / frames_counted)
+
+void stats_begin_frame(void) {
+    memset(&frame_stats, 0, sizeof(frame_stats));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Add the counters of other into stats. The arena high water mark is a level
+// rather than a count, so it keeps the higher of the two.
+///////////////////////////////////////////////////////////////////////////////
+void stats_merge(frame_stats_t* stats, frame_stats_t* other) {
+    stats->vertex_transforms += other->vertex_transforms;
+    stats->face_vertices += other->face_vertices;
+    stats->objects_culled += other->objects_culled;
+    stats->faces_outside_frustum += other->faces_outside_frustum;
+    stats->faces_clipped += other->faces_clipped;
+    stats->vertex_stage_time += other->vertex_stage_time;
+    stats->arena_used += other->arena_used;
+    stats->arena_heap_allocations += other->arena_heap_allocations;
+    if (other->arena_high_water_mark > stats->arena_high_water_mark) {
+        stats->arena_high_water_mark = other->arena_high_water_mark;
+    }
+    stats->pixels_depth_tested += other->pixels_depth_tested;
+    stats->pixels_depth_rejected += other->pixels_depth_rejected;
+    stats->triangles_occluded += other->triangles_occluded;
+    stats->pixels_tile_skipped += other->pixels_tile_skipped;
+    stats->pixels_shaded += other->pixels_shaded;
+    stats->raster_time += other->raster_time;
+    stats->affine_error_samples += other->affine_error_samples;
+    stats->affine_error_sum += other->affine_error_sum;
+    if (other->affine_error_max > stats->affine_error_max) {
+        stats->affine_error_max = other->affine_error_max;
+    }
+    stats->wire_lines += other->wire_lines;
+    stats->wire_edges_shared += other->wire_edges_shared;
+    stats->triangles_binned += other->triangles_binned;
+    stats->tile_pass_time += other->tile_pass_time;
+    stats->frame_time += other->frame_time;
+    if (other->frame_time_max > stats->frame_time_max) {
+        stats->frame_time_max = other->frame_time_max;
+    }
+    stats->present_time += other->present_time;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Accumulate the frame counters and print their average every second
+///////////////////////////////////////////////////////////////////////////////
+void stats_end_frame(void) {
+    // Real frame time, from the end of the last frame, including input and the frame pacing
+    Uint64 frame_end = SDL_GetPerformanceCounter();
+    if (previous_frame_end != 0) {
+        frame_stats.frame_time = frame_end - previous_frame_end;
+        frame_stats.frame_time_max = frame_stats.frame_time;
+    }
+    previous_frame_end = frame_end;
+
+    job_system_merge_stats(&frame_stats);
+    stats_merge(&totals, &frame_stats);
+    frames_counted++;
+
+    Uint32 now = SDL_GetTicks();
+    if (now - report_start_time < 1000) {
+        return;
+    }
+
+    if (stats_enabled) {
+        double ticks_per_us = SDL_GetPerformanceFrequency() / 1000000.0;
+        char pacing[32];
+        if (frame_pacing == PACING_TARGET_RATE) {
+            snprintf(pacing, sizeof(pacing), "%d fps target", target_frame_rate);
+        } else {
+            snprintf(pacing, sizeof(pacing), "%s", frame_pacing == PACING_VSYNC ? "vsync" : "uncapped");
+        }
+        printf("%d fps\n", frames_counted);
+        printf(
+            "  frames: %.2f ms average, %.2f ms longest, %.2f ms presenting and pacing (%s)\n",
+            AVERAGE(frame_time) / ticks_per_us / 1000, totals.frame_time_max / ticks_per_us / 1000,
+            AVERAGE(present_time) / ticks_per_us / 1000, pacing
+        );
+        printf(
+            "  vertices: %.0f transformed/frame (%.0f per-face) in %.1f us\n",
+            AVERAGE(vertex_transforms), AVERAGE(face_vertices), AVERAGE(vertex_stage_time) / ticks_per_us
+        );
+        printf(
+            "  culling: %.1f objects, %.1f faces outside frustum, %.1f faces clipped\n",
+            AVERAGE(objects_culled), AVERAGE(faces_outside_frustum), AVERAGE(faces_clipped)
+        );
+        printf(
+            "  arena: %.1f KB/frame, high water %.1f KB, %d heap allocs\n",
+            AVERAGE(arena_used) / 1024, frame_stats.arena_high_water_mark / 1024.0, totals.arena_heap_allocations
+        );
+        printf(
+            "  raster: %.0f pixels shaded/frame in %.1f us (%.1f ns/pixel)\n",
+            AVERAGE(pixels_shaded), AVERAGE(raster_time) / ticks_per_us,
+            totals.pixels_shaded > 0 ? totals.raster_time * 1000.0 / ticks_per_us / totals.pixels_shaded : 0.0
+        );
+        if (totals.triangles_binned > 0) {
+            printf(
+                "  tiles: %.0f triangles binned/frame, drawn by %d threads in %.1f us\n",
+                AVERAGE(triangles_binned), job_threads, AVERAGE(tile_pass_time) / ticks_per_us
+            );
+        }
+        if (totals.affine_error_samples > 0) {
+            printf(
+                "  affine: %.3f mean, %.2f max texel error at %d-pixel segment midpoints\n",
+                totals.affine_error_sum / totals.affine_error_samples, totals.affine_error_max, RASTER_AFFINE_SPAN
+            );
+        }
+        if (totals.wire_lines > 0) {
+            printf(
+                "  wireframe: %.0f lines/frame, %.0f shared triangle edges skipped\n",
+                AVERAGE(wire_lines), AVERAGE(wire_edges_shared)
+            );
+        }
+        if (totals.pixels_depth_tested > 0) {
+            printf(
+                "  depth: %.0f pixels tested/frame, %.0f rejected before shading\n",
+                AVERAGE(pixels_depth_tested), AVERAGE(pixels_depth_rejected)
+            );
+            printf(
+                "  depth tiles: %.1f triangles occluded/frame, %.0f span pixels skipped\n",
+                AVERAGE(triangles_occluded), AVERAGE(pixels_tile_skipped)
+            );
+        }
+    }
+
+    memset(&totals, 0, sizeof(totals));
+    frames_counted = 0;
+    report_start_time = now;
+}
@@ -0,0 +1,55 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+////////////////////////////////////////////////////////////////////////////////
+// Per-frame counters that are averaged and printed once per second while
+// stats_enabled is set (off by default, toggled with the P key)
+////////////////////////////////////////////////////////////////////////////////
+typedef struct {
+    int vertex_transforms; // vertices run through the world matrix and projection
+    int face_vertices;     // vertices referenced by faces (transforms without a cache)
+    int objects_culled;         // meshes skipped because their bounds are outside the frustum
+    int faces_outside_frustum;  // faces rejected with all vertices outside one frustum plane
+    int faces_clipped;          // faces clipped against the frustum planes they cross
+    uint64_t vertex_stage_time; // performance counter ticks spent in the vertex stage
+    size_t arena_used;          // bytes of transient data allocated from the frame arena
+    size_t arena_high_water_mark; // most bytes the frame arena has held in any frame
+    int arena_heap_allocations; // blocks the frame arena had to malloc this frame
+    uint64_t pixels_depth_tested;   // pixels compared against the z-buffer
+    uint64_t pixels_depth_rejected; // pixels hidden by the z-buffer, skipping their shading
+    int triangles_occluded;         // triangles behind every depth tile they overlap
+    uint64_t pixels_tile_skipped;   // span pixels skipped inside depth tiles in front of them
+    uint64_t pixels_shaded;         // pixels written by the filled and textured triangles
+    uint64_t raster_time;           // performance counter ticks spent rasterizing triangles
+    uint64_t affine_error_samples;  // affine texture segments measured against the exact divide
+    double affine_error_sum;        // texel error summed over the measured segment midpoints
+    float affine_error_max;         // largest texel error at a segment midpoint
+    int wire_lines;                 // lines drawn by the wireframe
+    int wire_edges_shared;          // triangle edges left to a neighbor sharing the mesh edge
+    int triangles_binned;           // triangles sorted into screen tiles, once per tile they overlap
+    uint64_t tile_pass_time;        // performance counter ticks from binning to the last tile drawn
+    uint64_t frame_time;            // performance counter ticks from the end of the last frame to the end of this one
+    uint64_t frame_time_max;        // longest frame_time of the frames merged together
+    uint64_t present_time;          // performance counter ticks presenting and waiting for the frame pacing
+} frame_stats_t;
+
+// Every thread counts into its own frame_stats, and the job system merges
+// those of its workers into the main thread's at the end of each frame
+#if defined(_MSC_VER)
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL __thread
+#endif
+
+extern THREAD_LOCAL frame_stats_t frame_stats;
+extern bool stats_enabled;
+
+void stats_begin_frame(void);
+void stats_merge(frame_stats_t* stats, frame_stats_t* other);
+void stats_end_frame(void);
+
+#endif
@@ -2,21 +2,28 @@
 #include "texture.h"
 #include "upng.h"
 
-int texture_width = 64;
-int texture_height = 64;
+bool load_png_texture_data(texture_t* texture, char* filename) {
+  texture->png = upng_new_from_file(filename);
+  texture->pixels = NULL;
+  texture->width = 0;
+  texture->height = 0;
+  if (texture->png != NULL) {
+    upng_decode(texture->png);
 
-upng_t *png_texture = NULL;
-uint32_t* mesh_texture = NULL;
-
-void load_png_texture_data(char *filename) {
-  png_texture = upng_new_from_file(filename);
-  if (png_texture != NULL) {
-    upng_decode(png_texture);
-
-    if (upng_get_error(png_texture) == UPNG_EOK) {
-      mesh_texture = (uint32_t*)upng_get_buffer(png_texture);
-      texture_width = upng_get_width(png_texture);
-      texture_height = upng_get_height(png_texture);
+    if (upng_get_error(texture->png) == UPNG_EOK) {
+      texture->pixels = (uint32_t*)upng_get_buffer(texture->png);
+      texture->width = upng_get_width(texture->png);
+      texture->height = upng_get_height(texture->png);
+      return true;
     }
   }
+  return false;
+}
+
+void free_texture(texture_t* texture) {
+  if (texture->png != NULL) {
+    upng_free(texture->png);
+  }
+  texture->png = NULL;
+  texture->pixels = NULL;
 }
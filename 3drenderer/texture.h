@@ -1,6 +1,7 @@
 #ifndef TEXTURE_H
 #define TEXTURE_H
 
+#include <stdbool.h>
 #include <stdint.h>
 #include "upng.h"
 
@@ -9,11 +10,16 @@ typedef struct {
     float v;
 } tex2_t;
 
-extern int texture_width;
-extern int texture_height;
-
-extern upng_t* png_texture;
-extern uint32_t* mesh_texture;
+////////////////////////////////////////////////////////////////////////////////
+// Decoded texture image, with the pixels owned by the png decoder
+////////////////////////////////////////////////////////////////////////////////
+typedef struct {
+    upng_t* png;      // decoder holding the pixel buffer
+    uint32_t* pixels; // texture colors, NULL when no texture is loaded
+    int width;
+    int height;
+} texture_t;
 
-void load_png_texture_data(char* filename);
+bool load_png_texture_data(texture_t* texture, char* filename);
+void free_texture(texture_t* texture);
 #endif
@@ -0,0 +1,230 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include "display.h"
+#include "transform.h"
+
+#if TRANSFORM_SIMD_WIDTH == 8
+#include <immintrin.h>
+#elif TRANSFORM_SIMD_WIDTH == 4
+#include <emmintrin.h>
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// Over-allocate and stash the original pointer right before the aligned block
+///////////////////////////////////////////////////////////////////////////////
+void* aligned_malloc(size_t size, size_t alignment) {
+    void* raw = malloc(size + alignment + sizeof(void*));
+    if (raw == NULL) {
+        return NULL;
+    }
+    uintptr_t start = (uintptr_t)raw + sizeof(void*);
+    uintptr_t aligned = (start + alignment - 1) & ~(uintptr_t)(alignment - 1);
+    ((void**)aligned)[-1] = raw;
+    return (void*)aligned;
+}
+
+void aligned_free(void* ptr) {
+    if (ptr != NULL) {
+        free(((void**)ptr)[-1]);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Split an array of vec3_t into padded x, y, and z streams
+///////////////////////////////////////////////////////////////////////////////
+void vertex_streams_init(vertex_streams_t* streams, vec3_t* vertices, int count) {
+    int padded_count = (count + 7) & ~7;
+    size_t stream_size = sizeof(float) * (padded_count > 0 ? padded_count : 8);
+
+    streams->x = (float*)aligned_malloc(stream_size, VERTEX_STREAM_ALIGNMENT);
+    streams->y = (float*)aligned_malloc(stream_size, VERTEX_STREAM_ALIGNMENT);
+    streams->z = (float*)aligned_malloc(stream_size, VERTEX_STREAM_ALIGNMENT);
+    streams->count = count;
+
+    for (int i = 0; i < padded_count; i++) {
+        streams->x[i] = (i < count) ? vertices[i].x : 0;
+        streams->y[i] = (i < count) ? vertices[i].y : 0;
+        streams->z[i] = (i < count) ? vertices[i].z : 0;
+    }
+}
+
+void vertex_streams_free(vertex_streams_t* streams) {
+    aligned_free(streams->x);
+    aligned_free(streams->y);
+    aligned_free(streams->z);
+    streams->x = streams->y = streams->z = NULL;
+    streams->count = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Perspective divide a clip space vertex and map it into screen space
+///////////////////////////////////////////////////////////////////////////////
+vec4_t clip_to_screen(vec4_t clip_vertex) {
+    vec4_t projected_point = clip_vertex;
+
+    // Perform perspective divide with original z-value that is now stored in w
+    if (projected_point.w != 0.0) {
+        projected_point.x /= projected_point.w;
+        projected_point.y /= projected_point.w;
+        projected_point.z /= projected_point.w;
+    }
+
+    // Flip vertically since the y values of the 3D mesh grow bottom->up and in screen space y values grow top->down
+    projected_point.y *= -1;
+
+    // Scale into the view
+    projected_point.x *= (window_width / 2.0);
+    projected_point.y *= (window_height / 2.0);
+
+    // Translate the projected points to the middle of the screen
+    projected_point.x += (window_width / 2.0);
+    projected_point.y += (window_height / 2.0);
+
+    return projected_point;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Reference kernel, one vertex at a time through mat4_mul_vec4 with the
+// concatenated projection * view * world matrix
+///////////////////////////////////////////////////////////////////////////////
+void transform_vertices_scalar(
+    vertex_streams_t* streams, int first, int last, mat4_t mvp_matrix,
+    vec4_t* clip_vertices, vec4_t* projected_vertices
+) {
+    for (int i = first; i < last; i++) {
+        vec4_t vertex = { streams->x[i], streams->y[i], streams->z[i], 1.0 };
+        clip_vertices[i] = mat4_mul_vec4(mvp_matrix, vertex);
+        projected_vertices[i] = clip_to_screen(clip_vertices[i]);
+    }
+}
+
+#if TRANSFORM_SIMD_WIDTH == 8
+///////////////////////////////////////////////////////////////////////////////
+// AVX kernel, 8 vertices per iteration. The products and sums are evaluated
+// in the same order as mat4_mul_vec4 so the results match the scalar path.
+///////////////////////////////////////////////////////////////////////////////
+#define ROW8(mat, r, x, y, z, w) \
+    _mm256_add_ps(_mm256_add_ps(_mm256_add_ps( \
+        _mm256_mul_ps(_mm256_set1_ps((mat).m[r][0]), x), _mm256_mul_ps(_mm256_set1_ps((mat).m[r][1]), y)), \
+        _mm256_mul_ps(_mm256_set1_ps((mat).m[r][2]), z)), _mm256_mul_ps(_mm256_set1_ps((mat).m[r][3]), w))
+
+static void store_vec4x8(vec4_t* out, __m256 x, __m256 y, __m256 z, __m256 w) {
+    __m256 t0 = _mm256_unpacklo_ps(x, y); // x0 y0 x1 y1 | x4 y4 x5 y5
+    __m256 t1 = _mm256_unpackhi_ps(x, y); // x2 y2 x3 y3 | x6 y6 x7 y7
+    __m256 t2 = _mm256_unpacklo_ps(z, w); // z0 w0 z1 w1 | z4 w4 z5 w5
+    __m256 t3 = _mm256_unpackhi_ps(z, w); // z2 w2 z3 w3 | z6 w6 z7 w7
+    __m256 v0 = _mm256_shuffle_ps(t0, t2, 0x44); // vertex 0 | vertex 4
+    __m256 v1 = _mm256_shuffle_ps(t0, t2, 0xEE); // vertex 1 | vertex 5
+    __m256 v2 = _mm256_shuffle_ps(t1, t3, 0x44); // vertex 2 | vertex 6
+    __m256 v3 = _mm256_shuffle_ps(t1, t3, 0xEE); // vertex 3 | vertex 7
+    float* dst = (float*)out;
+    _mm256_storeu_ps(dst + 0, _mm256_permute2f128_ps(v0, v1, 0x20));
+    _mm256_storeu_ps(dst + 8, _mm256_permute2f128_ps(v2, v3, 0x20));
+    _mm256_storeu_ps(dst + 16, _mm256_permute2f128_ps(v0, v1, 0x31));
+    _mm256_storeu_ps(dst + 24, _mm256_permute2f128_ps(v2, v3, 0x31));
+}
+
+static int transform_vertices_simd(
+    vertex_streams_t* streams, int first, int last, mat4_t mvp_matrix, vec4_t* clip_vertices, vec4_t* projected_vertices
+) {
+    __m256 one = _mm256_set1_ps(1.0f);
+    __m256 zero = _mm256_setzero_ps();
+    __m256 sign = _mm256_set1_ps(-0.0f);
+    __m256 half_width = _mm256_set1_ps(window_width / 2.0f);
+    __m256 half_height = _mm256_set1_ps(window_height / 2.0f);
+
+    int end = first + ((last - first) & ~7);
+    for (int i = first; i < end; i += 8) {
+        __m256 x = _mm256_load_ps(streams->x + i);
+        __m256 y = _mm256_load_ps(streams->y + i);
+        __m256 z = _mm256_load_ps(streams->z + i);
+
+        // Single transform into clip space followed by the perspective divide, skipped for lanes where w is zero
+        __m256 px = ROW8(mvp_matrix, 0, x, y, z, one);
+        __m256 py = ROW8(mvp_matrix, 1, x, y, z, one);
+        __m256 pz = ROW8(mvp_matrix, 2, x, y, z, one);
+        __m256 pw = ROW8(mvp_matrix, 3, x, y, z, one);
+        store_vec4x8(&clip_vertices[i], px, py, pz, pw);
+        __m256 divisor = _mm256_blendv_ps(one, pw, _mm256_cmp_ps(pw, zero, _CMP_NEQ_UQ));
+        px = _mm256_div_ps(px, divisor);
+        py = _mm256_div_ps(py, divisor);
+        pz = _mm256_div_ps(pz, divisor);
+
+        // Flip vertically, scale into the view, and translate to the middle of the screen
+        py = _mm256_xor_ps(py, sign);
+        px = _mm256_add_ps(_mm256_mul_ps(px, half_width), half_width);
+        py = _mm256_add_ps(_mm256_mul_ps(py, half_height), half_height);
+        store_vec4x8(&projected_vertices[i], px, py, pz, pw);
+    }
+    return end;
+}
+#elif TRANSFORM_SIMD_WIDTH == 4
+///////////////////////////////////////////////////////////////////////////////
+// SSE2 kernel, 4 vertices per iteration. The products and sums are evaluated
+// in the same order as mat4_mul_vec4 so the results match the scalar path.
+///////////////////////////////////////////////////////////////////////////////
+#define ROW4(mat, r, x, y, z, w) \
+    _mm_add_ps(_mm_add_ps(_mm_add_ps( \
+        _mm_mul_ps(_mm_set1_ps((mat).m[r][0]), x), _mm_mul_ps(_mm_set1_ps((mat).m[r][1]), y)), \
+        _mm_mul_ps(_mm_set1_ps((mat).m[r][2]), z)), _mm_mul_ps(_mm_set1_ps((mat).m[r][3]), w))
+
+static void store_vec4x4(vec4_t* out, __m128 x, __m128 y, __m128 z, __m128 w) {
+    _MM_TRANSPOSE4_PS(x, y, z, w);
+    float* dst = (float*)out;
+    _mm_storeu_ps(dst + 0, x);
+    _mm_storeu_ps(dst + 4, y);
+    _mm_storeu_ps(dst + 8, z);
+    _mm_storeu_ps(dst + 12, w);
+}
+
+static int transform_vertices_simd(
+    vertex_streams_t* streams, int first, int last, mat4_t mvp_matrix, vec4_t* clip_vertices, vec4_t* projected_vertices
+) {
+    __m128 one = _mm_set1_ps(1.0f);
+    __m128 zero = _mm_setzero_ps();
+    __m128 sign = _mm_set1_ps(-0.0f);
+    __m128 half_width = _mm_set1_ps(window_width / 2.0f);
+    __m128 half_height = _mm_set1_ps(window_height / 2.0f);
+
+    int end = first + ((last - first) & ~3);
+    for (int i = first; i < end; i += 4) {
+        __m128 x = _mm_load_ps(streams->x + i);
+        __m128 y = _mm_load_ps(streams->y + i);
+        __m128 z = _mm_load_ps(streams->z + i);
+
+        // Single transform into clip space followed by the perspective divide, skipped for lanes where w is zero
+        __m128 px = ROW4(mvp_matrix, 0, x, y, z, one);
+        __m128 py = ROW4(mvp_matrix, 1, x, y, z, one);
+        __m128 pz = ROW4(mvp_matrix, 2, x, y, z, one);
+        __m128 pw = ROW4(mvp_matrix, 3, x, y, z, one);
+        store_vec4x4(&clip_vertices[i], px, py, pz, pw);
+        __m128 nonzero = _mm_cmpneq_ps(pw, zero);
+        __m128 divisor = _mm_or_ps(_mm_and_ps(nonzero, pw), _mm_andnot_ps(nonzero, one));
+        px = _mm_div_ps(px, divisor);
+        py = _mm_div_ps(py, divisor);
+        pz = _mm_div_ps(pz, divisor);
+
+        // Flip vertically, scale into the view, and translate to the middle of the screen
+        py = _mm_xor_ps(py, sign);
+        px = _mm_add_ps(_mm_mul_ps(px, half_width), half_width);
+        py = _mm_add_ps(_mm_mul_ps(py, half_height), half_height);
+        store_vec4x4(&projected_vertices[i], px, py, pz, pw);
+    }
+    return end;
+}
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// Transform and project the vertices from first to last with the widest
+// kernel compiled in, finishing the remainder that doesn't fill a whole vector
+// with the scalar path. first must be a multiple of 8 for the aligned loads.
+///////////////////////////////////////////////////////////////////////////////
+void transform_vertices(
+    vertex_streams_t* streams, int first, int last, mat4_t mvp_matrix,
+    vec4_t* clip_vertices, vec4_t* projected_vertices
+) {
+#if TRANSFORM_SIMD_WIDTH > 1
+    first = transform_vertices_simd(streams, first, last, mvp_matrix, clip_vertices, projected_vertices);
+#endif
+    transform_vertices_scalar(streams, first, last, mvp_matrix, clip_vertices, projected_vertices);
+}
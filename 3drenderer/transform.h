@@ -0,0 +1,46 @@
+#ifndef TRANSFORM_H
+#define TRANSFORM_H
+
+#include <stddef.h>
+#include "matrix.h"
+#include "vector.h"
+
+#if defined(__AVX__)
+#define TRANSFORM_SIMD_WIDTH 8
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TRANSFORM_SIMD_WIDTH 4
+#else
+#define TRANSFORM_SIMD_WIDTH 1
+#endif
+
+#define VERTEX_STREAM_ALIGNMENT 32
+
+////////////////////////////////////////////////////////////////////////////////
+// Structure-of-arrays vertex storage, with one 32-byte aligned stream per
+// coordinate padded to a multiple of 8 so SIMD kernels can load full vectors
+////////////////////////////////////////////////////////////////////////////////
+typedef struct {
+    float* x;  // aligned stream of x coordinates
+    float* y;  // aligned stream of y coordinates
+    float* z;  // aligned stream of z coordinates
+    int count; // number of vertices in the streams
+} vertex_streams_t;
+
+void* aligned_malloc(size_t size, size_t alignment);
+void aligned_free(void* ptr);
+
+void vertex_streams_init(vertex_streams_t* streams, vec3_t* vertices, int count);
+void vertex_streams_free(vertex_streams_t* streams);
+
+vec4_t clip_to_screen(vec4_t clip_vertex);
+
+void transform_vertices_scalar(
+    vertex_streams_t* streams, int first, int last, mat4_t mvp_matrix,
+    vec4_t* clip_vertices, vec4_t* projected_vertices
+);
+void transform_vertices(
+    vertex_streams_t* streams, int first, int last, mat4_t mvp_matrix,
+    vec4_t* clip_vertices, vec4_t* projected_vertices
+);
+
+#endif
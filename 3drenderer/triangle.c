@@ -1,7 +1,72 @@
+#include <math.h>
 #include "display.h"
+#include "raster.h"
+#include "stats.h"
 #include "swap.h"
 #include "triangle.h"
 
+///////////////////////////////////////////////////////////////////////////////
+// Screen space plane 1/w = a*x + b*y + c, since 1/w varies linearly across the
+// projected triangle. It is set up once per triangle for the depth test.
+///////////////////////////////////////////////////////////////////////////////
+typedef struct {
+    float a;
+    float b;
+    float c;
+    float nearest; // largest 1/w of the triangle vertices
+} depth_plane_t;
+
+static depth_plane_t make_depth_plane(int x0, int y0, float w0, int x1, int y1, float w1, int x2, int y2, float w2) {
+    float q0 = 1 / w0;
+    float q1 = 1 / w1;
+    float q2 = 1 / w2;
+    float det = (float)(x1 - x0) * (y2 - y0) - (float)(x2 - x0) * (y1 - y0);
+
+    float nearest = q0 > q1 ? q0 : q1;
+    nearest = nearest > q2 ? nearest : q2;
+
+    // Degenerate triangles cover no area, so use the nearest depth of their vertices
+    if (det == 0) {
+        depth_plane_t plane = { 0, 0, nearest, nearest };
+        return plane;
+    }
+
+    depth_plane_t plane;
+    plane.nearest = nearest;
+    plane.a = ((q1 - q0) * (y2 - y0) - (q2 - q0) * (y1 - y0)) / det;
+    plane.b = ((q2 - q0) * (x1 - x0) - (q1 - q0) * (x2 - x0)) / det;
+    plane.c = q0 - plane.a * x0 - plane.b * y0;
+    return plane;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Fill one horizontal scanline, depth testing every pixel when a plane is given
+///////////////////////////////////////////////////////////////////////////////
+static void fill_scanline(int x_start, int x_end, int y, uint32_t color, depth_plane_t* depth_plane) {
+    if (depth_plane == NULL) {
+        frame_stats.pixels_shaded += fill_span(x_start, x_end, y, color);
+        return;
+    }
+    if (x_end < x_start) {
+        int_swap(&x_start, &x_end);
+    }
+    for (int x = x_start; x <= x_end; x++) {
+        // Skip the rest of the depth tile when it is entirely in front of the triangle
+        if (use_depth_tiles && (x == x_start || x % DEPTH_TILE_SIZE == 0)) {
+            int skipped = occluded_tile_span(x, x_end + 1, y, depth_plane->nearest);
+            if (skipped > 0) {
+                x += skipped - 1;
+                continue;
+            }
+        }
+        float reciprocal_w = depth_plane->a * x + depth_plane->b * y + depth_plane->c;
+        if (depth_test(x, y, fminf(reciprocal_w, depth_plane->nearest))) {
+            draw_pixel(x, y, color);
+            frame_stats.pixels_shaded++;
+        }
+    }
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // Draw a filled a triangle with a flat bottom
 ///////////////////////////////////////////////////////////////////////////////
@@ -15,7 +80,7 @@
 //  (x1,y1)------(x2,y2)
 //
 ///////////////////////////////////////////////////////////////////////////////
-void fill_flat_bottom_triangle(int x0, int y0, int x1, int y1, int x2, int y2, uint32_t color) {
+void fill_flat_bottom_triangle(int x0, int y0, int x1, int y1, int x2, int y2, uint32_t color, depth_plane_t* depth_plane) {
     // Find the two slopes (two triangle legs)
     float inv_slope_1 = (float)(x1 - x0) / (y1 - y0);
     float inv_slope_2 = (float)(x2 - x0) / (y2 - y0);
@@ -26,7 +91,7 @@ void fill_flat_bottom_triangle(int x0, int y0, int x1, int y1, int x2, int y2, u
 
     // Loop all the scanlines from top to bottom
     for (int y = y0; y <= y2; y++) {
-        draw_line(x_start, y, x_end, y, color);
+        fill_scanline(x_start, x_end, y, color, depth_plane);
         x_start += inv_slope_1;
         x_end += inv_slope_2;
     }
@@ -45,7 +110,7 @@ void fill_flat_bottom_triangle(int x0, int y0, int x1, int y1, int x2, int y2, u
 //        (x2,y2)
 //
 ///////////////////////////////////////////////////////////////////////////////
-void fill_flat_top_triangle(int x0, int y0, int x1, int y1, int x2, int y2, uint32_t color) {
+void fill_flat_top_triangle(int x0, int y0, int x1, int y1, int x2, int y2, uint32_t color, depth_plane_t* depth_plane) {
     // Find the two slopes (two triangle legs)
     float inv_slope_1 = (float)(x2 - x0) / (y2 - y0);
     float inv_slope_2 = (float)(x2 - x1) / (y2 - y1);
@@ -56,7 +121,7 @@ void fill_flat_top_triangle(int x0, int y0, int x1, int y1, int x2, int y2, uint
 
     // Loop all the scanlines from bottom to top
     for (int y = y2; y >= y0; y--) {
-        draw_line(x_start, y, x_end, y, color);
+        fill_scanline(x_start, x_end, y, color, depth_plane);
         x_start -= inv_slope_1;
         x_end -= inv_slope_2;
     }
@@ -85,7 +150,18 @@ void fill_flat_top_triangle(int x0, int y0, int x1, int y1, int x2, int y2, uint
 //                         (x2,y2)
 //
 ///////////////////////////////////////////////////////////////////////////////
-void draw_filled_triangle(int x0, int y0, int x1, int y1, int x2, int y2, uint32_t color) {
+static void scanline_filled_triangle(int x0, int y0, float w0, int x1, int y1, float w1, int x2, int y2, float w2, uint32_t color) {
+    // Set up the depth plane from the original vertices when the z-buffer is in use
+    depth_plane_t plane;
+    depth_plane_t* depth_plane = NULL;
+    if (depth_method == DEPTH_BUFFER) {
+        plane = make_depth_plane(x0, y0, w0, x1, y1, w1, x2, y2, w2);
+        depth_plane = &plane;
+        if (use_depth_tiles && triangle_occluded(x0, y0, x1, y1, x2, y2, plane.nearest)) {
+            return;
+        }
+    }
+
     // We need to sort the vertices by y-coordinate ascending (y0 < y1 < y2)
     if (y0 > y1) {
         int_swap(&y0, &y1);
@@ -102,30 +178,44 @@ void draw_filled_triangle(int x0, int y0, int x1, int y1, int x2, int y2, uint32
 
     if (y1 == y2) {
         // Draw flat-bottom triangle
-        fill_flat_bottom_triangle(x0, y0, x1, y1, x2, y2, color);
+        fill_flat_bottom_triangle(x0, y0, x1, y1, x2, y2, color, depth_plane);
     } else if (y0 == y1) {
         // Draw flat-top triangle
-        fill_flat_top_triangle(x0, y0, x1, y1, x2, y2, color);
+        fill_flat_top_triangle(x0, y0, x1, y1, x2, y2, color, depth_plane);
     } else {
         // Calculate the new vertex (Mx,My) using triangle similarity
         int My = y1;
         int Mx = (((x2 - x0) * (y1 - y0)) / (y2 - y0)) + x0;
 
         // Draw flat-bottom triangle
-        fill_flat_bottom_triangle(x0, y0, x1, y1, Mx, My, color);
+        fill_flat_bottom_triangle(x0, y0, x1, y1, Mx, My, color, depth_plane);
 
         // Draw flat-top triangle
-        fill_flat_top_triangle(x1, y1, Mx, My, x2, y2, color);
+        fill_flat_top_triangle(x1, y1, Mx, My, x2, y2, color, depth_plane);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Draw a filled triangle with the selected rasterizer. The edge rasterizer
+// takes the subpixel vertex positions and writes only inside the clip
+// rectangle. The scanline one truncates them and always draws the whole
+// window, so it must be given the window rectangle.
+///////////////////////////////////////////////////////////////////////////////
+void draw_filled_triangle(float x0, float y0, float w0, float x1, float y1, float w1, float x2, float y2, float w2, uint32_t color, rect_t clip) {
+    if (raster_method == RASTER_EDGE) {
+        rasterize_filled_triangle(x0, y0, w0, x1, y1, w1, x2, y2, w2, color, clip);
+    } else {
+        scanline_filled_triangle(x0, y0, w0, x1, y1, w1, x2, y2, w2, color);
     }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-// Draw a triangle using three raw line calls
+// Draw the outline of a triangle with one line call per edge in the mask
 ///////////////////////////////////////////////////////////////////////////////
-void draw_triangle(int x0, int y0, int x1, int y1, int x2, int y2, uint32_t color) {
-    draw_line(x0, y0, x1, y1, color);
-    draw_line(x1, y1, x2, y2, color);
-    draw_line(x2, y2, x0, y0, color);
+void draw_triangle(int x0, int y0, int x1, int y1, int x2, int y2, uint8_t edges, uint32_t color, rect_t clip) {
+    if (edges & TRIANGLE_EDGE_AB) draw_line(x0, y0, x1, y1, color, clip);
+    if (edges & TRIANGLE_EDGE_BC) draw_line(x1, y1, x2, y2, color, clip);
+    if (edges & TRIANGLE_EDGE_CA) draw_line(x2, y2, x0, y0, color, clip);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -170,7 +260,7 @@ vec3_t barycentric_weights(vec2_t a, vec2_t b, vec2_t c, vec2_t p) {
 // Function to draw the textured pixel at position x and y using interpolation
 ///////////////////////////////////////////////////////////////////////////////
 void draw_texel(
-    int x, int y, uint32_t* texture,
+    int x, int y, texture_t* texture,
     vec4_t point_a, vec4_t point_b, vec4_t point_c,
     tex2_t a_uv, tex2_t b_uv, tex2_t c_uv
 ) {
@@ -190,22 +280,219 @@ void draw_texel(
     float interpolated_v;
     float interpolated_reciprocal_w;
 
+    // Interpolate the value of 1/w for the current pixel
+    interpolated_reciprocal_w = (1 / point_a.w) * alpha + (1 / point_b.w) * beta + (1 / point_c.w) * gamma;
+
+    // Reject hidden pixels before interpolating the texture coordinates and fetching the texel.
+    // Pixels on the edges extrapolate slightly past the triangle, so the depth is clamped to its
+    // nearest vertex to stay consistent with the depth tile rejection.
+    if (depth_method == DEPTH_BUFFER) {
+        float nearest_reciprocal_w = fmaxf(fmaxf(1 / point_a.w, 1 / point_b.w), 1 / point_c.w);
+        if (!depth_test(x, y, fminf(interpolated_reciprocal_w, nearest_reciprocal_w))) {
+            return;
+        }
+    }
+
     // Perform the interpolation of all U/w and V/w values using barycentric weights and a factor of 1/w
     interpolated_u = (a_uv.u / point_a.w) * alpha + (b_uv.u / point_b.w) * beta + (c_uv.u / point_c.w) * gamma;
     interpolated_v = (a_uv.v / point_a.w) * alpha + (b_uv.v / point_b.w) * beta + (c_uv.v / point_c.w) * gamma;
 
-    // Also interpolate the value of 1/w for the current pixel
-    interpolated_reciprocal_w = (1 / point_a.w) * alpha + (1 / point_b.w) * beta + (1 / point_c.w) * gamma;
-
     // Now we can divide back both interpolated values by 1/w
     interpolated_u /= interpolated_reciprocal_w;
     interpolated_v /= interpolated_reciprocal_w;
 
-    // Map the UV coordinate to the full texture width and height
-    int tex_x = abs((int)(interpolated_u * texture_width));
-    int tex_y = abs((int)(interpolated_v * texture_height));
+    // Map the UV coordinate to the full texture width and height, wrapping the coordinates
+    // that reach or extrapolate past the edge of the texture
+    int tex_x = abs((int)(interpolated_u * texture->width)) % texture->width;
+    int tex_y = abs((int)(interpolated_v * texture->height)) % texture->height;
+
+    draw_pixel(x, y, texture->pixels[(texture->width * tex_y) + tex_x]);
+    frame_stats.pixels_shaded++;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Screen space plane of an attribute divided by w, as its value at the first
+// vertex and its steps for one pixel right and one row down
+///////////////////////////////////////////////////////////////////////////////
+typedef struct {
+    int x0, y0;
+    float value;
+    float dx;
+    float dy;
+} attribute_plane_t;
+
+static attribute_plane_t make_attribute_plane(int x0, int y0, float a0, int x1, int y1, float a1, int x2, int y2, float a2) {
+    attribute_plane_t plane = { x0, y0, a0, 0, 0 };
+    float det = (float)(x1 - x0) * (y2 - y0) - (float)(x2 - x0) * (y1 - y0);
+    if (det != 0) {
+        plane.dx = ((a1 - a0) * (y2 - y0) - (a2 - a0) * (y1 - y0)) / det;
+        plane.dy = ((a2 - a0) * (x1 - x0) - (a1 - a0) * (x2 - x0)) / det;
+    }
+    return plane;
+}
+
+static float attribute_plane_at(attribute_plane_t* plane, int x, int y) {
+    return plane->value + plane->dx * (x - plane->x0) + plane->dy * (y - plane->y0);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Everything a span of the scanline textured triangle needs, with the planes
+// only set up for incremental interpolation
+///////////////////////////////////////////////////////////////////////////////
+typedef struct {
+    texture_t* texture;
+    vec4_t point_a, point_b, point_c;
+    tex2_t a_uv, b_uv, c_uv;
+    attribute_plane_t reciprocal_w;
+    attribute_plane_t u_over_w;
+    attribute_plane_t v_over_w;
+    float nearest_reciprocal_w;
+    bool test_tiles;
+    bool affine;
+} textured_span_t;
+
+///////////////////////////////////////////////////////////////////////////////
+// Affine subdivision of a span, like the edge rasterizer's. Segments are cut
+// at multiples of RASTER_AFFINE_SPAN, clamped to the span before it is
+// clipped to the screen, with exact texture coordinates at both ends and
+// linear ones in between.
+///////////////////////////////////////////////////////////////////////////////
+typedef struct {
+    int x_left, x_right; // whole span
+    int base;            // first pixel of the current segment cell, or -1 before the first
+    int start, end;      // current segment clamped to the span
+    float u_start, v_start;
+    float u_step, v_step;
+} span_segment_t;
+
+static void span_texture_coordinates_at(textured_span_t* span, int x, int y, float* u, float* v) {
+    float w = 1 / attribute_plane_at(&span->reciprocal_w, x, y);
+    *u = attribute_plane_at(&span->u_over_w, x, y) * w;
+    *v = attribute_plane_at(&span->v_over_w, x, y) * w;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Make the segment holding pixel x current, measuring the texel error at its
+// midpoint when stats are enabled
+///////////////////////////////////////////////////////////////////////////////
+static void span_segment_at(span_segment_t* segment, textured_span_t* span, int x, int y) {
+    int base = x - (x % RASTER_AFFINE_SPAN);
+    if (base == segment->base) {
+        return;
+    }
+    int start = base > segment->x_left ? base : segment->x_left;
+    int end = base + RASTER_AFFINE_SPAN < segment->x_right ? base + RASTER_AFFINE_SPAN : segment->x_right;
+    segment->base = base;
+    segment->start = start;
+    segment->end = end;
+    span_texture_coordinates_at(span, start, y, &segment->u_start, &segment->v_start);
+    segment->u_step = segment->v_step = 0;
+    if (end > start) {
+        float u_end, v_end;
+        span_texture_coordinates_at(span, end, y, &u_end, &v_end);
+        segment->u_step = (u_end - segment->u_start) / (end - start);
+        segment->v_step = (v_end - segment->v_start) / (end - start);
+    }
+
+    if (stats_enabled && end - start >= 2) {
+        texture_t* texture = span->texture;
+        int middle = start + (end - start) / 2;
+        float u_exact, v_exact;
+        span_texture_coordinates_at(span, middle, y, &u_exact, &v_exact);
+        float u_error = fabsf(segment->u_start + (middle - start) * segment->u_step - u_exact) * texture->width;
+        float v_error = fabsf(segment->v_start + (middle - start) * segment->v_step - v_exact) * texture->height;
+        float error = fmaxf(u_error, v_error);
+        frame_stats.affine_error_sum += error;
+        frame_stats.affine_error_samples++;
+        if (error > frame_stats.affine_error_max) {
+            frame_stats.affine_error_max = error;
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Draw the textured pixels from x_start up to x_end. Barycentric interpolation
+// recomputes the weights of every pixel in draw_texel. Incremental
+// interpolation evaluates 1/w, u/w and v/w once at the span start and steps
+// them with additions, paying only the divide back by 1/w per pixel. The
+// affine mode steps them the same way for the depth test, but takes the
+// texture coordinates from the affine segments instead of dividing.
+///////////////////////////////////////////////////////////////////////////////
+static void draw_textured_span(int x_start, int x_end, int y, textured_span_t* span) {
+    texture_t* texture = span->texture;
+    if (texel_interpolation == INTERPOLATE_BARYCENTRIC && !span->affine) {
+        for (int x = x_start; x < x_end; x++) {
+            // Skip the rest of the depth tile when it is entirely in front of the triangle
+            if (span->test_tiles && (x == x_start || x % DEPTH_TILE_SIZE == 0)) {
+                int skipped = occluded_tile_span(x, x_end, y, span->nearest_reciprocal_w);
+                if (skipped > 0) {
+                    x += skipped - 1;
+                    continue;
+                }
+            }
+
+            // Draw our pixel with the color that comes from the texture
+            draw_texel(x, y, texture, span->point_a, span->point_b, span->point_c, span->a_uv, span->b_uv, span->c_uv);
+        }
+        return;
+    }
+
+    // Clip the span to the screen once instead of bounds checking every pixel
+    if (y < 0 || y >= window_height) {
+        return;
+    }
+    span_segment_t segment = { .x_left = x_start, .x_right = x_end, .base = -1 };
+    if (x_start < 0) x_start = 0;
+    if (x_end > window_width) x_end = window_width;
+
+    bool test_depth = depth_method == DEPTH_BUFFER;
+    float q = attribute_plane_at(&span->reciprocal_w, x_start, y);
+    float uq = attribute_plane_at(&span->u_over_w, x_start, y);
+    float vq = attribute_plane_at(&span->v_over_w, x_start, y);
+    float dq = span->reciprocal_w.dx;
+    float duq = span->u_over_w.dx;
+    float dvq = span->v_over_w.dx;
+    int pixels_shaded = 0;
+
+    for (int x = x_start; x < x_end; x++, q += dq, uq += duq, vq += dvq) {
+        // Skip the rest of the depth tile when it is entirely in front of the triangle,
+        // stepping through the skipped pixels so the sums do not depend on the tiles
+        if (span->test_tiles && (x == x_start || x % DEPTH_TILE_SIZE == 0)) {
+            int skipped = occluded_tile_span(x, x_end, y, span->nearest_reciprocal_w);
+            if (skipped > 0) {
+                for (int i = 1; i < skipped; i++) {
+                    q += dq;
+                    uq += duq;
+                    vq += dvq;
+                }
+                x += skipped - 1;
+                continue;
+            }
+        }
+
+        // Reject hidden pixels before fetching the texel
+        if (test_depth && !depth_test(x, y, fminf(q, span->nearest_reciprocal_w))) {
+            continue;
+        }
+
+        float u, v;
+        if (span->affine) {
+            span_segment_at(&segment, span, x, y);
+            u = segment.u_start + (x - segment.start) * segment.u_step;
+            v = segment.v_start + (x - segment.start) * segment.v_step;
+        } else {
+            u = uq / q;
+            v = vq / q;
+        }
+        int tex_x = abs((int)(u * texture->width));
+        int tex_y = abs((int)(v * texture->height));
+        if (tex_x >= texture->width) tex_x %= texture->width;
+        if (tex_y >= texture->height) tex_y %= texture->height;
 
-    draw_pixel(x, y, texture[(texture_width * tex_y) + tex_x]);
+        color_buffer[(window_width * y) + x] = texture->pixels[(texture->width * tex_y) + tex_x];
+        pixels_shaded++;
+    }
+    frame_stats.pixels_shaded += pixels_shaded;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -228,11 +515,11 @@ void draw_texel(
 //                    v2
 //
 ///////////////////////////////////////////////////////////////////////////////
-void draw_textured_triangle(
+static void scanline_textured_triangle(
     int x0, int y0, float z0, float w0, float u0, float v0,
     int x1, int y1, float z1, float w1, float u1, float v1,
     int x2, int y2, float z2, float w2, float u2, float v2,
-    uint32_t* texture
+    texture_t* texture
 ) {
     // We need to sort the vertices by y-coordinate ascending (y0 < y1 < y2)
     if (y0 > y1) {
@@ -268,6 +555,29 @@ void draw_textured_triangle(
     tex2_t b_uv = { u1, v1 };
     tex2_t c_uv = { u2, v2 };
 
+    // Reject the whole triangle when the depth tiles it overlaps are all in front of it
+    bool test_tiles = depth_method == DEPTH_BUFFER && use_depth_tiles;
+    float nearest_reciprocal_w = 1 / w0;
+    if (1 / w1 > nearest_reciprocal_w) nearest_reciprocal_w = 1 / w1;
+    if (1 / w2 > nearest_reciprocal_w) nearest_reciprocal_w = 1 / w2;
+    if (test_tiles && triangle_occluded(x0, y0, x1, y1, x2, y2, nearest_reciprocal_w)) {
+        return;
+    }
+
+    textured_span_t span = {
+        .texture = texture,
+        .point_a = point_a, .point_b = point_b, .point_c = point_c,
+        .a_uv = a_uv, .b_uv = b_uv, .c_uv = c_uv,
+        .nearest_reciprocal_w = nearest_reciprocal_w,
+        .test_tiles = test_tiles,
+        .affine = render_method == RENDER_TEXTURED_AFFINE
+    };
+    if (texel_interpolation == INTERPOLATE_INCREMENTAL || span.affine) {
+        span.reciprocal_w = make_attribute_plane(x0, y0, 1 / w0, x1, y1, 1 / w1, x2, y2, 1 / w2);
+        span.u_over_w = make_attribute_plane(x0, y0, u0 / w0, x1, y1, u1 / w1, x2, y2, u2 / w2);
+        span.v_over_w = make_attribute_plane(x0, y0, v0 / w0, x1, y1, v1 / w1, x2, y2, v2 / w2);
+    }
+
     ///////////////////////////////////////////////////////
     // Render the upper part of the triangle (flat-bottom)
     ///////////////////////////////////////////////////////
@@ -286,10 +596,7 @@ void draw_textured_triangle(
                 int_swap(&x_start, &x_end); // swap if x_start is to the right of x_end
             }
 
-            for (int x = x_start; x < x_end; x++) {
-                // Draw our pixel with the color that comes from the texture
-                draw_texel(x, y, texture, point_a, point_b, point_c, a_uv, b_uv, c_uv);
-            }
+            draw_textured_span(x_start, x_end, y, &span);
         }
     }
 
@@ -311,10 +618,34 @@ void draw_textured_triangle(
                 int_swap(&x_start, &x_end); // swap if x_start is to the right of x_end
             }
 
-            for (int x = x_start; x < x_end; x++) {
-                // Draw our pixel with the color that comes from the texture
-                draw_texel(x, y, texture, point_a, point_b, point_c, a_uv, b_uv, c_uv);
-            }
+            draw_textured_span(x_start, x_end, y, &span);
         }
     }
 }
+
+///////////////////////////////////////////////////////////////////////////////
+// Draw a textured triangle with the selected rasterizer, clipped like the
+// filled one
+///////////////////////////////////////////////////////////////////////////////
+void draw_textured_triangle(
+    float x0, float y0, float z0, float w0, float u0, float v0,
+    float x1, float y1, float z1, float w1, float u1, float v1,
+    float x2, float y2, float z2, float w2, float u2, float v2,
+    texture_t* texture, rect_t clip
+) {
+    if (raster_method == RASTER_EDGE) {
+        rasterize_textured_triangle(
+            x0, y0, w0, u0, v0,
+            x1, y1, w1, u1, v1,
+            x2, y2, w2, u2, v2,
+            texture, clip
+        );
+    } else {
+        scanline_textured_triangle(
+            x0, y0, z0, w0, u0, v0,
+            x1, y1, z1, w1, u1, v1,
+            x2, y2, z2, w2, u2, v2,
+            texture
+        );
+    }
+}
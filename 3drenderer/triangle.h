@@ -2,6 +2,7 @@
 #define TRIANGLE_H
 
 #include <stdint.h>
+#include "display.h"
 #include "texture.h"
 #include "vector.h"
 
@@ -15,21 +16,30 @@ typedef struct {
     uint32_t color;
 } face_t;
 
+// Bits of triangle_t.wire_edges for the edges AB, BC, and CA
+#define TRIANGLE_EDGE_AB 0x1
+#define TRIANGLE_EDGE_BC 0x2
+#define TRIANGLE_EDGE_CA 0x4
+#define TRIANGLE_ALL_EDGES (TRIANGLE_EDGE_AB | TRIANGLE_EDGE_BC | TRIANGLE_EDGE_CA)
+
 typedef struct {
     vec4_t points[3];
     tex2_t texcoords[3];
     uint32_t color;
     float avg_depth;
+    texture_t* texture;
+    uint8_t wire_edges; // edges this triangle draws in the wireframe modes
+    int face_index;     // mesh face the triangle was made from, -1 for pieces of clipped faces
 } triangle_t;
 
-void draw_triangle(int x0, int y0, int x1, int y1, int x2, int y2, uint32_t color);
-void draw_filled_triangle(int x0, int y0, int x1, int y1, int x2, int y2, uint32_t color);
+void draw_triangle(int x0, int y0, int x1, int y1, int x2, int y2, uint8_t edges, uint32_t color, rect_t clip);
+void draw_filled_triangle(float x0, float y0, float w0, float x1, float y1, float w1, float x2, float y2, float w2, uint32_t color, rect_t clip);
 
 void draw_textured_triangle(
-    int x0, int y0, float z0, float w0, float u0, float v0,
-    int x1, int y1, float z1, float w1, float u1, float v1,
-    int x2, int y2, float z2, float w2, float u2, float v2,
-    uint32_t* texture
+    float x0, float y0, float z0, float w0, float u0, float v0,
+    float x1, float y1, float z1, float w1, float u1, float v1,
+    float x2, float y2, float z2, float w2, float u2, float v2,
+    texture_t* texture, rect_t clip
 );
 
 #endif